@@ -0,0 +1,21 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include "espirit.hpp"
+#include "log.hpp"
+
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE("ESPIRIT", "[espirit]")
+{
+  rl::Log::SetLevel(rl::Log::Level::Testing);
+  Index const nC = 8;
+  Index const M = 32;
+  rl::Cx4 grid(nC, M, M, M);
+  grid.setRandom();
+
+  BENCHMARK("ESPIRIT")
+  {
+    return rl::ESPIRIT(grid, rl::Sz3{M, M, M}, 3, 4, 0, 0.015f);
+  };
+}
@@ -2,10 +2,12 @@
 
 #include "../src/info.hpp"
 #include "../src/op/make_grid.hpp"
+#include "../src/threads.hpp"
 #include "../src/traj_spirals.h"
 
 #include <catch2/benchmark/catch_benchmark_all.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <thread>
 
 using namespace rl;
 
@@ -83,3 +85,93 @@ TEST_CASE("GridBasis", "[grid]")
     gridfi5->forward(c);
   };
 }
+
+TEST_CASE("GridThreads", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  auto gridfi5 = make_grid<Cx, 3>(traj, "ES5", os, C);
+  Cx5 c(gridfi5->inputDimensions());
+  Cx3 nc(gridfi5->outputDimensions());
+  nc.setRandom();
+  Index const maxThreads = std::thread::hardware_concurrency();
+  for (Index ii = 1; ii < 2 * maxThreads; ii *= 2) {
+    Index const nT = std::min(ii, maxThreads);
+    Threads::SetGlobalThreadCount(nT);
+    BENCHMARK(fmt::format("ES5 Noncartesian->Cartesian {} threads", nT))
+    {
+      gridfi5->adjoint(nc);
+    };
+  }
+  Threads::SetGlobalThreadCount(maxThreads);
+}
+
+TEST_CASE("GridChannels", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  for (Index const nC : {1, 4, 8, 12, 16, 32}) {
+    auto gridfi5 = make_grid<Cx, 3>(traj, "ES5", os, nC);
+    Cx5 c(gridfi5->inputDimensions());
+    Cx3 nc(gridfi5->outputDimensions());
+    c.setRandom();
+    nc.setRandom();
+    BENCHMARK(fmt::format("ES5 Noncartesian->Cartesian {} channels", nC))
+    {
+      gridfi5->adjoint(nc);
+    };
+    BENCHMARK(fmt::format("ES5 Cartesian->Noncartesian {} channels", nC))
+    {
+      gridfi5->forward(c);
+    };
+  }
+}
+
+TEST_CASE("GridCenterHeavy", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  // 3D radial, sample density falls off as 1/r^2 so the central buckets dominate
+  Index const nR = M / 2, nT = M * M * 2;
+  Re3 radial(3, nR, nT);
+  for (Index it = 0; it < nT; it++) {
+    float const z = 1.f - 2.f * (it + 0.5f) / nT, phi = it * 2.39996f, r = std::sqrt(1.f - z * z);
+    for (Index is = 0; is < nR; is++) {
+      float const rad = 0.5f * is / nR;
+      radial(0, is, it) = rad * r * std::cos(phi);
+      radial(1, is, it) = rad * r * std::sin(phi);
+      radial(2, is, it) = rad * z;
+    }
+  }
+  Trajectory const radTraj(info, radial);
+  auto gridfi5 = make_grid<Cx, 3>(radTraj, "ES5", os, C);
+  Cx5 c(gridfi5->inputDimensions());
+  Cx3 nc(gridfi5->outputDimensions());
+  c.setRandom();
+  nc.setRandom();
+  BENCHMARK("ES5 Center-Heavy Noncartesian->Cartesian")
+  {
+    gridfi5->adjoint(nc);
+  };
+  BENCHMARK("ES5 Center-Heavy Cartesian->Noncartesian")
+  {
+    gridfi5->forward(c);
+  };
+}
+
+TEST_CASE("GridSorted", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  for (bool const sorted : {false, true}) {
+    auto gridfi5 = make_grid<Cx, 3>(traj, "ES5", os, C, std::nullopt, GridOpts{.sorted = sorted});
+    Cx5 c(gridfi5->inputDimensions());
+    Cx3 nc(gridfi5->outputDimensions());
+    c.setRandom();
+    nc.setRandom();
+    BENCHMARK(fmt::format("ES5 Noncartesian->Cartesian sorted data {}", sorted))
+    {
+      gridfi5->adjoint(nc);
+    };
+    BENCHMARK(fmt::format("ES5 Cartesian->Noncartesian sorted data {}", sorted))
+    {
+      gridfi5->forward(c);
+    };
+  }
+}
@@ -0,0 +1,49 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include "../src/io/hd5.hpp"
+#include "../src/log.hpp"
+
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fmt/format.h>
+
+using namespace rl;
+
+TEST_CASE("IO", "[io]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const C = 8, samples = 256, traces = 4096, slabs = 1, volumes = 2;
+  Cx5 data(C, samples, traces, slabs, volumes);
+  data.setRandom();
+  std::filesystem::path const fname("bench-io.h5");
+
+  std::vector<std::pair<std::string, HD5::Compression>> const settings{
+    {"None", HD5::Compression{.level = 0}},
+    {"Shuffle", HD5::Compression{.level = 0, .shuffle = true}},
+    {"Deflate1", HD5::Compression{.level = 1}},
+    {"Deflate2", HD5::Compression{.level = 2}},
+    {"Deflate2-Shuffle", HD5::Compression{.level = 2, .shuffle = true}},
+    {"Deflate6", HD5::Compression{.level = 6}}};
+
+  for (auto const &s : settings) {
+    HD5::SetCompression(s.second);
+    BENCHMARK(fmt::format("Write-{}", s.first))
+    {
+      HD5::Writer writer(fname);
+      writer.writeTensor(data, HD5::Keys::Noncartesian);
+    };
+    BENCHMARK(fmt::format("Read-{}", s.first))
+    {
+      HD5::Reader reader(fname);
+      return reader.readTensor<Cx5>(HD5::Keys::Noncartesian);
+    };
+    BENCHMARK(fmt::format("Slab-{}", s.first))
+    {
+      HD5::Reader reader(fname);
+      return reader.readSlab<Cx4>(HD5::Keys::Noncartesian, volumes - 1);
+    };
+  }
+  HD5::SetCompression(HD5::Compression{});
+  std::filesystem::remove(fname);
+}
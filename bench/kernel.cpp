@@ -8,7 +8,9 @@
 #include "kernel/nn.hpp"
 #include "kernel/radial.hpp"
 #include "kernel/rectilinear.hpp"
+#include "kernel/tabulated.hpp"
 #include "kernel/triangle.hpp"
+#include "tensorOps.hpp"
 #include "types.hpp"
 
 using namespace rl;
@@ -41,3 +43,41 @@ TEST_CASE(
     es(p);
   };
 }
+
+template <typename Exact, typename Tab>
+void CompareTabulated(std::string const &name)
+{
+  Exact exact(2.f);
+  Tab tab(2.f);
+  typename Exact::Point p;
+  float maxErr = 0.f;
+  for (Index ii = 0; ii < 1024; ii++) {
+    p.setRandom();
+    p = p * 0.5f;
+    Eigen::Tensor<float, 0> const err = (exact(p) - tab(p)).abs().maximum();
+    maxErr = std::max(maxErr, err());
+  }
+  INFO(name);
+  CHECK(maxErr < 1.e-4f);
+  p.setConstant(0.5f);
+  BENCHMARK(name + " Exact")
+  {
+    exact(p);
+  };
+  BENCHMARK(name + " Tabulated")
+  {
+    tab(p);
+  };
+}
+
+TEST_CASE("Tabulated", "[kernels]")
+{
+  CompareTabulated<rl::Radial<3, rl::ExpSemi<5>>, rl::Radial<3, rl::Tabulated<rl::ExpSemi<5>, 1>>>("ES5 Linear");
+  CompareTabulated<rl::Radial<3, rl::ExpSemi<5>>, rl::Radial<3, rl::Tabulated<rl::ExpSemi<5>, 3>>>("ES5 Cubic");
+  CompareTabulated<rl::Radial<3, rl::KaiserBessel<5>>, rl::Radial<3, rl::Tabulated<rl::KaiserBessel<5>, 1>>>("KB5 Linear");
+  CompareTabulated<rl::Radial<3, rl::KaiserBessel<5>>, rl::Radial<3, rl::Tabulated<rl::KaiserBessel<5>, 3>>>("KB5 Cubic");
+  CompareTabulated<rl::Rectilinear<3, rl::ExpSemi<5>>, rl::Rectilinear<3, rl::Tabulated<rl::ExpSemi<5>, 1>>>(
+    "rectES5 Linear");
+  CompareTabulated<rl::Rectilinear<3, rl::ExpSemi<5>>, rl::Rectilinear<3, rl::Tabulated<rl::ExpSemi<5>, 3>>>(
+    "rectES5 Cubic");
+}
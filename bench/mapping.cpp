@@ -0,0 +1,23 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include "../src/info.hpp"
+#include "../src/mapping.hpp"
+#include "../src/traj_spirals.h"
+
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+using namespace rl;
+
+TEST_CASE("Mapping", "[mapping]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 128;
+  Info const info{.matrix = Sz3{M, M, M}};
+  Trajectory const traj(info, ArchimedeanSpiral(M / 2, M * M * 4));
+
+  BENCHMARK("Mapping construction")
+  {
+    return Mapping<3>(traj, 2.f, 4);
+  };
+}
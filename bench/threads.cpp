@@ -0,0 +1,51 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include "../src/log.hpp"
+#include "../src/threads.hpp"
+
+#include <catch2/benchmark/catch_benchmark_all.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <unsupported/Eigen/CXX11/ThreadPool>
+
+using namespace rl;
+
+TEST_CASE("Threads", "[threads]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const N = 1 << 16;
+  std::vector<float> x(N, 1.f);
+  auto work = [&](Index const ii) { x[ii] = std::sqrt(x[ii] + ii); };
+
+  Eigen::ThreadPool pool(Threads::GlobalThreadCount());
+  BENCHMARK("TaskPerIndex") // The scheduling scheme Threads::For used to have
+  {
+    Eigen::Barrier barrier(N);
+    for (Index ii = 0; ii < N; ii++) {
+      pool.Schedule([&, ii] {
+        work(ii);
+        barrier.Notify();
+      });
+    }
+    barrier.Wait();
+  };
+  BENCHMARK("Dynamic-1") { Threads::For(work, 0, N, 1, Threads::Schedule::Dynamic, "Dynamic"); };
+  BENCHMARK("Dynamic-64") { Threads::For(work, 0, N, 64, Threads::Schedule::Dynamic, "Dynamic"); };
+  BENCHMARK("Dynamic-1024") { Threads::For(work, 0, N, 1024, Threads::Schedule::Dynamic, "Dynamic"); };
+  BENCHMARK("Static-64") { Threads::For(work, 0, N, 64, Threads::Schedule::Static, "Static"); };
+
+  // Skewed costs, like the buckets of a center-out trajectory
+  Index const nB = 512;
+  std::vector<Index> cost(nB);
+  for (Index ib = 0; ib < nB; ib++) {
+    cost[ib] = ib % 64 == 0 ? 4096 : 64;
+  }
+  auto skewed = [&](Index const ib) {
+    float sum = 0.f;
+    for (Index ii = 0; ii < cost[ib] * 16; ii++) {
+      sum += std::sqrt(float(ii));
+    }
+    x[ib] = sum;
+  };
+  BENCHMARK("Skewed-Index-Order") { Threads::For(skewed, nB, "Skewed"); };
+  BENCHMARK("Skewed-Cost-Order") { Threads::For(skewed, cost, "Skewed"); };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common.hpp"
+#include "op/operator.hpp"
 #include "signals.hpp"
 #include "threads.hpp"
 
@@ -37,6 +38,47 @@ auto make_normal(std::shared_ptr<Op> op)
   return std::make_shared<NormalEqOp<Op>>(op);
 }
 
+/*
+ * Wrapper for the regularized normal equations (A'A + λF'F). If F is not given it is the identity.
+ */
+template <typename Op, typename Opλ>
+struct RegularizedNormalEqOp
+{
+  using Input = typename Op::Input;
+  using InputMap = typename Op::InputMap;
+
+  std::shared_ptr<Op> op;
+  std::shared_ptr<Opλ> opλ;
+  float λ;
+  Input mutable y;
+
+  RegularizedNormalEqOp(std::shared_ptr<Op> o, std::shared_ptr<Opλ> oλ, float const l)
+    : op{o}
+    , opλ{oλ}
+    , λ{l}
+  {
+  }
+
+  auto inputDimensions() const { return op->inputDimensions(); }
+
+  auto outputDimensions() const { return op->inputDimensions(); }
+
+  auto forward(Input const &x) const -> InputMap
+  {
+    auto dev = Threads::GlobalDevice();
+    op->input() = x;
+    y = op->adjfwd(op->input());
+    if (opλ) {
+      Workspace::Lease<Input> xc(x.dimensions());
+      xc->device(dev) = x;
+      y.device(dev) = y + opλ->adjoint(opλ->forward(InputMap(*xc))) * y.constant(λ);
+    } else if (λ > 0.f) {
+      y.device(dev) = y + x * x.constant(λ);
+    }
+    return InputMap(y);
+  }
+};
+
 template <typename Op>
 struct ConjugateGradients
 {
@@ -50,10 +92,12 @@ struct ConjugateGradients
   Input run(InputMap const b, Input const &x0 = Input()) const
   {
     auto dev = Threads::GlobalDevice();
-    // Allocate all memory
+    // Only x is returned, the others are borrowed so repeated solves do not allocate
     CheckDimsEqual(op->outputDimensions(), b.dimensions());
     auto const dims = op->inputDimensions();
-    Input q(dims), p(dims), r(dims), x(dims);
+    Workspace::Lease<Input> lq(dims), lp(dims), lr(dims);
+    Input &q = *lq, &p = *lp, &r = *lr;
+    Input x(dims);
     // If we have an initial guess, use it
     if (x0.size()) {
       CheckDimsEqual(dims, x0.dimensions());
@@ -98,4 +142,40 @@ struct ConjugateGradients
   }
 };
 
+/*
+ * Solves the same least-squares problems as LSMR, but via CG on the normal equations. This means only op->adjfwd is
+ * needed in the iterations, which can be much cheaper than forward and adjoint, e.g. with a Töplitz embedding.
+ * Without b0 this solves (A'A + λ²I)x = A'b, with b0 (A'A + λF'F)x = A'b + √λF'b0.
+ */
+template <typename Op, typename Opλ = Operator<typename Op::Scalar, Op::InputRank, Op::InputRank>>
+struct NormalCG
+{
+  using Input = typename Op::Input;
+  using Output = typename Op::Output;
+  using Outputλ = typename Opλ::Output;
+
+  std::shared_ptr<Op> op;
+  Index iterLimit = 8;
+  float resTol = 1.e-6f;
+  bool debug = false;
+  std::shared_ptr<Opλ> opλ = nullptr;
+
+  Input run(Eigen::TensorMap<Output const> b, float const λ = 0.f, Input const &x0 = Input(), Outputλ const &b0 = Input()) const
+  {
+    auto dev = Threads::GlobalDevice();
+    Output bc = b;
+    Input rhs = op->adjoint(bc);
+    std::shared_ptr<RegularizedNormalEqOp<Op, Opλ>> normal;
+    if (b0.size()) {
+      Outputλ b0c = b0;
+      rhs.device(dev) = rhs + opλ->adjoint(typename Opλ::OutputMap(b0c)) * rhs.constant(std::sqrt(λ));
+      normal = std::make_shared<RegularizedNormalEqOp<Op, Opλ>>(op, opλ, λ);
+    } else {
+      normal = std::make_shared<RegularizedNormalEqOp<Op, Opλ>>(op, nullptr, λ * λ);
+    }
+    ConjugateGradients<RegularizedNormalEqOp<Op, Opλ>> cg{normal, iterLimit, resTol, debug};
+    return cg.run(rhs, x0);
+  }
+};
+
 } // namespace rl
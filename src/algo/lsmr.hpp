@@ -41,8 +41,12 @@ struct LSMR
     auto const inDims = op->inputDimensions();
     auto const outDims = op->outputDimensions();
     CheckDimsEqual(b.dimensions(), outDims);
-    Output Mu(outDims), u(outDims);
-    Input v(inDims), h(inDims), h̅(inDims), x(inDims);
+    // Borrowed so repeated solves do not allocate, only x is returned
+    Workspace::Lease<Output> lMu(outDims), lu(outDims);
+    Workspace::Lease<Input> lv(inDims), lh(inDims), lh̅(inDims);
+    Output &Mu = *lMu, &u = *lu;
+    Input &v = *lv, &h = *lh, &h̅ = *lh̅;
+    Input x(inDims);
     Outputλ uλ(b0.dimensions());
     float α = 0.f, β = 0.f;
     BidiagInit(op, M, Mu, u, v, α, β, λ, opλ, uλ, x, b, x0, b0, dev);
@@ -41,9 +41,12 @@ struct LSQR
     auto const inDims = op->inputDimensions();
     auto const outDims = op->outputDimensions();
 
-    // Workspace variables
-    Output Mu(outDims), u(outDims);
-    Input x(inDims), v(inDims), w(inDims);
+    // Workspace variables, borrowed so repeated solves do not allocate
+    Workspace::Lease<Output> lMu(outDims), lu(outDims);
+    Workspace::Lease<Input> lv(inDims), lw(inDims);
+    Output &Mu = *lMu, &u = *lu;
+    Input &v = *lv, &w = *lw;
+    Input x(inDims);
     Outputλ uλ;
     float α = 0.f, β = 0.f;
     BidiagInit(op, M, Mu, u, v, α, β, λ, opλ, uλ, x, b, x0, cc, dev);
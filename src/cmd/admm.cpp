@@ -2,6 +2,7 @@
 
 #include "algo/admm-augmented.hpp"
 #include "algo/admm.hpp"
+#include "algo/cg.hpp"
 #include "algo/lsmr.hpp"
 #include "algo/lsqr.hpp"
 #include "cropper.h"
@@ -16,6 +17,7 @@
 #include "precond.hpp"
 #include "sdc.hpp"
 #include "sense.hpp"
+#include "volumes.hpp"
 
 using namespace rl;
 
@@ -32,6 +34,8 @@ int main_admm(args::Subparser &parser)
   args::ValueFlag<float> atol(parser, "A", "Tolerance on A", {"atol"}, 1.e-6f);
   args::ValueFlag<float> btol(parser, "B", "Tolerance on b", {"btol"}, 1.e-6f);
   args::ValueFlag<float> ctol(parser, "C", "Tolerance on cond(A)", {"ctol"}, 1.e-6f);
+  args::Flag toeplitz(parser, "T", "Inner solve with CG on the normal equations and a Töplitz embedding", {"toe", 't'});
+  args::ValueFlag<Index> toeBlock(parser, "C", "Process C channels at a time in the Töplitz embedding (all)", {"toe-block"}, 0);
 
   args::ValueFlag<Index> outer_its(parser, "ITS", "ADMM max iterations (8)", {"max-outer-its"}, 8);
   args::ValueFlag<float> abstol(parser, "ABS", "ADMM absolute tolerance (1e-3)", {"abs-tol"}, 1.e-3f);
@@ -54,48 +58,51 @@ int main_admm(args::Subparser &parser)
   HD5::Reader reader(coreOpts.iname.Get());
   Trajectory traj(reader);
   Info const &info = traj.info();
-  auto recon = make_recon(coreOpts, sdcOpts, senseOpts, traj, false, reader);
+  auto recon = make_recon(coreOpts, sdcOpts, senseOpts, traj, toeplitz, reader, toeBlock.Get());
   auto const sz = recon->inputDimensions();
 
   Cropper out_cropper(info.matrix, LastN<3>(sz), info.voxel_size, coreOpts.fov.Get());
   Cx4 vol(sz);
   Sz3 outSz = out_cropper.size();
   Cx4 cropped(sz[0], outSz[0], outSz[1], outSz[2]);
-  Cx5 allData = reader.readTensor<Cx5>(HD5::Keys::Noncartesian);
-  Index const volumes = allData.dimension(4);
-  Cx5 out(sz[0], outSz[0], outSz[1], outSz[2], volumes);
+  Index const volumes = reader.dimensions<5>(HD5::Keys::Noncartesian)[4];
+  auto const fname = OutName(coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), "h5");
+  HD5::Writer writer(fname);
+  writer.createTensor<Cx, 5>(HD5::Keys::Image, Sz5{sz[0], outSz[0], outSz[1], outSz[2], volumes});
   auto M = make_pre(pre.Get(), traj, ReadBasis(coreOpts.basisFile.Get()), preBias.Get());
 
-  auto const &all_start = Log::Now();
+  // Run ADMM with either LSMR or CG on the normal equations as the inner solver
+  auto run = [&]<typename RegOp>(Regularizer<RegOp> const &reg) {
+    auto solve = [&](auto &inner) {
+      ADMM<std::remove_reference_t<decltype(inner)>, RegOp> admm{
+        inner, reg, outer_its.Get(), α.Get(), μ.Get(), τ.Get(), abstol.Get(), reltol.Get()};
+      ForVolumes(
+        reader,
+        HD5::Keys::Noncartesian,
+        [&](Index, Cx4 const &data) -> Cx4 { return out_cropper.crop4(admm.run(data, ρ.Get())); },
+        writer,
+        HD5::Keys::Image);
+    };
+    if (toeplitz) {
+      NormalCG<ReconOp, RegOp> inner{recon, inner_its.Get(), btol.Get(), false, reg.op};
+      solve(inner);
+    } else {
+      LSMR<ReconOp, RegOp> inner{recon, M, inner_its.Get(), atol.Get(), btol.Get(), ctol.Get(), false, preVar, reg.op};
+      solve(inner);
+    }
+  };
+
   if (wavelets) {
-    Regularizer<IdentityOp<Cx, 4>> reg{
+    run(Regularizer<IdentityOp<Cx, 4>>{
       .prox = std::make_shared<ThresholdWavelets>(sz, λ.Get(), width.Get(), wavelets.Get()),
-      .op = std::make_shared<IdentityOp<Cx, 4>>(sz)};
-    LSMR<ReconOp> lsmr{recon, M, inner_its.Get(), atol.Get(), btol.Get(), ctol.Get(), false, preVar, reg.op};
-    ADMM<LSMR<ReconOp>, IdentityOp<Cx, 4>> admm{
-      lsmr, reg, outer_its.Get(), α.Get(), μ.Get(), τ.Get(), abstol.Get(), reltol.Get()};
-    for (Index iv = 0; iv < volumes; iv++) {
-      out.chip<4>(iv) = out_cropper.crop4(admm.run(CChipMap(allData, iv), ρ.Get()));
-    }
+      .op = std::make_shared<IdentityOp<Cx, 4>>(sz)});
   } else if (patchSize) {
-    Regularizer<IdentityOp<Cx, 4>> reg{
-      .prox = std::make_shared<LLR>(λ.Get(), patchSize.Get(), winSize.Get()), .op = std::make_shared<IdentityOp<Cx, 4>>(sz)};
-    LSMR<ReconOp> lsmr{recon, M, inner_its.Get(), atol.Get(), btol.Get(), ctol.Get(), false, preVar, reg.op};
-    ADMM<LSMR<ReconOp>, IdentityOp<Cx, 4>> admm{
-      lsmr, reg, outer_its.Get(), α.Get(), μ.Get(), τ.Get(), abstol.Get(), reltol.Get()};
-    for (Index iv = 0; iv < volumes; iv++) {
-      out.chip<4>(iv) = out_cropper.crop4(admm.run(CChipMap(allData, iv), ρ.Get()));
-    }
+    run(Regularizer<IdentityOp<Cx, 4>>{
+      .prox = std::make_shared<LLR>(λ.Get(), patchSize.Get(), winSize.Get()), .op = std::make_shared<IdentityOp<Cx, 4>>(sz)});
   } else {
-    Regularizer<GradOp> reg{.prox = std::make_shared<SoftThreshold<Cx5>>(λ.Get()), .op = std::make_shared<GradOp>(sz)};
-    LSMR<ReconOp, GradOp> lsmr{recon, M, inner_its.Get(), atol.Get(), btol.Get(), ctol.Get(), false, preVar, reg.op};
-    ADMM<LSMR<ReconOp, GradOp>, GradOp> admm{lsmr, reg, outer_its.Get(), α.Get(), μ.Get(), τ.Get(), abstol.Get(), reltol.Get()};
-    for (Index iv = 0; iv < volumes; iv++) {
-      out.chip<4>(iv) = out_cropper.crop4(admm.run(CChipMap(allData, iv), ρ.Get()));
-    }
+    run(Regularizer<GradOp>{.prox = std::make_shared<SoftThreshold<Cx5>>(λ.Get()), .op = std::make_shared<GradOp>(sz)});
   }
 
-  Log::Print(FMT_STRING("All Volumes: {}"), Log::ToNow(all_start));
-  WriteOutput(out, coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), coreOpts.keepTrajectory, traj);
+  WriteTrajectory(writer, coreOpts.keepTrajectory, traj);
   return EXIT_SUCCESS;
 }
@@ -8,6 +8,7 @@
 #include "sense.hpp"
 #include "tensorOps.hpp"
 #include "threads.hpp"
+#include "volumes.hpp"
 
 using namespace rl;
 
@@ -17,33 +18,37 @@ int main_cg(args::Subparser &parser)
   SDC::Opts sdcOpts(parser);
   SENSE::Opts senseOpts(parser);
   args::Flag toeplitz(parser, "T", "Use Töplitz embedding", {"toe", 't'});
+  args::ValueFlag<Index> toeBlock(parser, "C", "Process C channels at a time in the Töplitz embedding (all)", {"toe-block"}, 0);
   args::ValueFlag<float> thr(parser, "T", "Termination threshold (1e-10)", {"thresh"}, 1.e-10);
   args::ValueFlag<Index> its(parser, "N", "Max iterations (8)", {"max-its"}, 8);
+  args::ValueFlag<Index> workers(parser, "W", "Reconstruct W volumes concurrently (1)", {"volume-workers"}, 1);
 
   ParseCommand(parser, coreOpts.iname);
 
   HD5::Reader reader(coreOpts.iname.Get());
   Trajectory traj(reader);
   Info const &info = traj.info();
-  auto recon = make_recon(coreOpts, sdcOpts, senseOpts, traj, toeplitz, reader);
-  auto normEqs = make_normal<ReconOp>(recon);
-  ConjugateGradients<NormalEqOp<ReconOp>> cg{normEqs, its.Get(), thr.Get(), true};
+  auto const setup = make_recon_setup(coreOpts, sdcOpts, senseOpts, traj, reader);
+  auto recon = make_recon(coreOpts, traj, setup, toeplitz, toeBlock.Get());
 
   auto sz = recon->inputDimensions();
   Cropper out_cropper(info.matrix, LastN<3>(sz), info.voxel_size, coreOpts.fov.Get());
   Sz3 outSz = out_cropper.size();
-  Cx4 cropped(sz[0], outSz[0], outSz[1], outSz[2]);
-  Cx5 allData = reader.readTensor<Cx5>(HD5::Keys::Noncartesian);
-  Index const volumes = allData.dimension(4);
-  Cx5 out(sz[0], outSz[0], outSz[1], outSz[2], volumes);
-  auto const &all_start = Log::Now();
-  for (Index iv = 0; iv < volumes; iv++) {
-    auto const &vol_start = Log::Now();
-    cropped = out_cropper.crop4(cg.run(recon->adjoint(CChipMap(allData, iv))));
-    out.chip<4>(iv) = cropped;
-    Log::Print(FMT_STRING("Volume {}: {}"), iv, Log::ToNow(vol_start));
+  Index const volumes = reader.dimensions<5>(HD5::Keys::Noncartesian)[4];
+  auto const fname = OutName(coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), "h5");
+  HD5::Writer writer(fname);
+  writer.createTensor<Cx, 5>(HD5::Keys::Image, Sz5{sz[0], outSz[0], outSz[1], outSz[2], volumes});
+  std::vector<VolumeFunc> funcs;
+  for (Index iw = 0; iw < std::max<Index>(workers.Get(), 1); iw++) {
+    auto r = iw == 0 ? recon : make_recon(coreOpts, traj, setup, toeplitz, toeBlock.Get());
+    auto normEqs = make_normal<ReconOp>(r);
+    ConjugateGradients<NormalEqOp<ReconOp>> cg{normEqs, its.Get(), thr.Get(), true};
+    funcs.push_back([&, r, cg](Index, Cx4 const &data) -> Cx4 {
+      Cx4 x = r->adjoint(data);
+      return out_cropper.crop4(cg.run(x));
+    });
   }
-  Log::Print(FMT_STRING("All Volumes: {}"), Log::ToNow(all_start));
-  WriteOutput(out, coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), coreOpts.keepTrajectory, traj);
+  ForVolumes(reader, HD5::Keys::Noncartesian, funcs, writer, HD5::Keys::Image);
+  WriteTrajectory(writer, coreOpts.keepTrajectory, traj);
   return EXIT_SUCCESS;
 }
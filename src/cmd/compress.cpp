@@ -36,10 +36,10 @@ int main_compress(args::Subparser &parser)
   ParseCommand(parser, coreOpts.iname);
 
   HD5::Reader reader(coreOpts.iname.Get());
-  Cx4 const ks = reader.readSlab<Cx4>(HD5::Keys::Noncartesian, refVol.Get());
-  Index const channels = ks.dimension(0);
-  Index const samples = ks.dimension(1);
-  Index const traces = ks.dimension(2);
+  auto const kDims = reader.dimensions<5>(HD5::Keys::Noncartesian);
+  Index const channels = kDims[0];
+  Index const samples = kDims[1];
+  Index const traces = kDims[2];
   Eigen::MatrixXcf psi;
   if (pca) {
     Index const maxRead = samples - pcaRead.Get()[0];
@@ -48,14 +48,17 @@ int main_compress(args::Subparser &parser)
       Log::Fail(FMT_STRING("Requested end spoke {} is past end of file {}"), pcaTraces.Get()[0] + pcaTraces.Get()[1], traces);
     }
     Log::Print(FMT_STRING("Using {} read points, {} traces, {} stride"), nread, pcaTraces.Get()[1], pcaTraces.Get()[2]);
-    Cx4 const ref = ks.slice(
-                        Sz4{0, pcaRead.Get()[0], pcaTraces.Get()[0], pcaSlices.Get()[0]},
-                        Sz4{channels, pcaRead.Get()[1], pcaTraces.Get()[1], pcaSlices.Get()[1]})
-                      .stride(Sz4{1, 1, pcaTraces.Get()[2], 1});
+    Index const stride = pcaTraces.Get()[2];
+    Cx5 const ref = reader.readSlice<Cx5>(
+      HD5::Keys::Noncartesian,
+      Sz5{0, pcaRead.Get()[0], pcaTraces.Get()[0], pcaSlices.Get()[0], refVol.Get()},
+      Sz5{channels, nread, (pcaTraces.Get()[1] + stride - 1) / stride, pcaSlices.Get()[1], 1},
+      Sz5{1, 1, stride, 1, 1});
 
     auto const pc = PCA(CollapseToConstMatrix(ref), nRetain.Get(), energy.Get());
     psi = pc.vecs;
   } else if (rovir) {
+    Cx4 const ks = reader.readSlab<Cx4>(HD5::Keys::Noncartesian, refVol.Get());
     psi = ROVIR(rovirOpts, Trajectory(reader), energy.Get(), nRetain.Get(), lores.Get(), ks);
   } else if (ccFile) {
     HD5::Reader matFile(ccFile.Get());
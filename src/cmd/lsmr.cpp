@@ -1,5 +1,6 @@
 #include "types.hpp"
 
+#include "algo/cg.hpp"
 #include "algo/lsmr.hpp"
 #include "cropper.h"
 #include "log.hpp"
@@ -10,6 +11,7 @@
 #include "sense.hpp"
 #include "tensorOps.hpp"
 #include "threads.hpp"
+#include "volumes.hpp"
 
 using namespace rl;
 
@@ -26,33 +28,41 @@ int main_lsmr(args::Subparser &parser)
   args::ValueFlag<float> btol(parser, "B", "Tolerance on b (1e-6)", {"btol"}, 1.e-6f);
   args::ValueFlag<float> ctol(parser, "C", "Tolerance on cond(A) (1e-6)", {"ctol"}, 1.e-6f);
   args::ValueFlag<float> λ(parser, "λ", "Tikhonov parameter (default 0)", {"lambda"}, 0.f);
+  args::Flag toeplitz(parser, "T", "Solve the normal equations with CG and a Töplitz embedding", {"toe", 't'});
+  args::ValueFlag<Index> toeBlock(parser, "C", "Process C channels at a time in the Töplitz embedding (all)", {"toe-block"}, 0);
 
   ParseCommand(parser, coreOpts.iname);
 
   HD5::Reader reader(coreOpts.iname.Get());
   Trajectory traj(reader);
   Info const &info = traj.info();
-  auto recon = make_recon(coreOpts, sdcOpts, senseOpts, traj, false, reader);
-  auto M = make_pre(pre.Get(), traj, ReadBasis(coreOpts.basisFile.Get()), preBias.Get());
-  LSMR<ReconOp> lsmr{recon, M, its.Get(), atol.Get(), btol.Get(), ctol.Get(), true, preVar};
+  auto recon = make_recon(coreOpts, sdcOpts, senseOpts, traj, toeplitz, reader, toeBlock.Get());
   auto sz = recon->inputDimensions();
   Cropper out_cropper(info.matrix, LastN<3>(sz), info.voxel_size, coreOpts.fov.Get());
-  Cx4 vol(sz);
   Sz3 outSz = out_cropper.size();
-  Cx4 cropped(sz[0], outSz[0], outSz[1], outSz[2]);
-  Cx5 allData = reader.readTensor<Cx5>(HD5::Keys::Noncartesian);
-  Index const volumes = allData.dimension(4);
-  Cx5 out(sz[0], outSz[0], outSz[1], outSz[2], volumes);
+  Index const volumes = reader.dimensions<5>(HD5::Keys::Noncartesian)[4];
+  auto const fname = OutName(coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), "h5");
+  HD5::Writer writer(fname);
+  writer.createTensor<Cx, 5>(HD5::Keys::Image, Sz5{sz[0], outSz[0], outSz[1], outSz[2], volumes});
 
-  auto const &all_start = Log::Now();
-  for (Index iv = 0; iv < volumes; iv++) {
-    auto const &vol_start = Log::Now();
-    vol = lsmr.run(CChipMap(allData, iv), λ.Get());
-    cropped = out_cropper.crop4(vol);
-    out.chip<4>(iv) = cropped;
-    Log::Print(FMT_STRING("Volume {}: {}"), iv, Log::ToNow(vol_start));
+  // Run either LSMR or CG on the normal equations, only one of them is built
+  auto solve = [&](auto const &solver) {
+    ForVolumes(
+      reader,
+      HD5::Keys::Noncartesian,
+      [&](Index, Cx4 const &data) -> Cx4 { return out_cropper.crop4(solver.run(data, λ.Get())); },
+      writer,
+      HD5::Keys::Image);
+  };
+  if (toeplitz) {
+    Log::Print("Solving the normal equations, the pre-conditioner and tolerances on A and cond(A) are not used");
+    NormalCG<ReconOp> normalCG{recon, its.Get(), btol.Get(), true};
+    solve(normalCG);
+  } else {
+    auto M = make_pre(pre.Get(), traj, ReadBasis(coreOpts.basisFile.Get()), preBias.Get());
+    LSMR<ReconOp> lsmr{recon, M, its.Get(), atol.Get(), btol.Get(), ctol.Get(), true, preVar};
+    solve(lsmr);
   }
-  Log::Print(FMT_STRING("All Volumes: {}"), Log::ToNow(all_start));
-  WriteOutput(out, coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), coreOpts.keepTrajectory, traj);
+  WriteTrajectory(writer, coreOpts.keepTrajectory, traj);
   return EXIT_SUCCESS;
 }
@@ -10,6 +10,7 @@
 #include "sense.hpp"
 #include "tensorOps.hpp"
 #include "threads.hpp"
+#include "volumes.hpp"
 
 using namespace rl;
 
@@ -38,22 +39,17 @@ int main_lsqr(args::Subparser &parser)
 
   auto sz = recon->inputDimensions();
   Cropper out_cropper(info.matrix, LastN<3>(sz), info.voxel_size, coreOpts.fov.Get());
-  Cx4 vol(sz);
   Sz3 outSz = out_cropper.size();
-  Cx4 cropped(sz[0], outSz[0], outSz[1], outSz[2]);
-  Cx5 allData = reader.readTensor<Cx5>(HD5::Keys::Noncartesian);
-  Index const volumes = allData.dimension(4);
-  Cx5 out(sz[0], outSz[0], outSz[1], outSz[2], volumes);
-
-  auto const &all_start = Log::Now();
-  for (Index iv = 0; iv < volumes; iv++) {
-    auto const &vol_start = Log::Now();
-    vol = lsqr.run(CChipMap(allData, iv), λ.Get());
-    cropped = out_cropper.crop4(vol);
-    out.chip<4>(iv) = cropped;
-    Log::Print(FMT_STRING("Volume {}: {}"), iv, Log::ToNow(vol_start));
-  }
-  Log::Print(FMT_STRING("All Volumes: {}"), Log::ToNow(all_start));
-  WriteOutput(out, coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), coreOpts.keepTrajectory, traj);
+  Index const volumes = reader.dimensions<5>(HD5::Keys::Noncartesian)[4];
+  auto const fname = OutName(coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), "h5");
+  HD5::Writer writer(fname);
+  writer.createTensor<Cx, 5>(HD5::Keys::Image, Sz5{sz[0], outSz[0], outSz[1], outSz[2], volumes});
+  ForVolumes(
+    reader,
+    HD5::Keys::Noncartesian,
+    [&](Index, Cx4 const &data) -> Cx4 { return out_cropper.crop4(lsqr.run(data, λ.Get())); },
+    writer,
+    HD5::Keys::Image);
+  WriteTrajectory(writer, coreOpts.keepTrajectory, traj);
   return EXIT_SUCCESS;
 }
@@ -41,8 +41,7 @@ int main_nufft(args::Subparser &parser)
       channels.dimension(0),
       traj.matrix(coreOpts.fov.Get()),
       basis,
-      std::make_shared<IdentityFunctor<Cx3>>(),
-      false);
+      std::make_shared<IdentityFunctor<Cx3>>());
     Cx5 noncart(AddBack(nufft->outputDimensions(), channels.dimension(5)));
     for (auto ii = 0; ii < channels.dimension(5); ii++) {
       noncart.chip<4>(ii).chip<3>(0).device(Threads::GlobalDevice()) = nufft->forward(CChipMap(channels, ii));
@@ -57,7 +56,7 @@ int main_nufft(args::Subparser &parser)
     auto const channels = noncart.dimension(0);
     auto const sdc = SDC::Choose(sdcOpts, traj, channels, coreOpts.ktype.Get(), coreOpts.osamp.Get());
     auto nufft = make_nufft(
-      traj, coreOpts.ktype.Get(), coreOpts.osamp.Get(), channels, traj.matrix(coreOpts.fov.Get()), basis, sdc, false);
+      traj, coreOpts.ktype.Get(), coreOpts.osamp.Get(), channels, traj.matrix(coreOpts.fov.Get()), basis, sdc);
 
     Cx6 output(AddBack(nufft->inputDimensions(), noncart.dimension(3)));
     for (auto ii = 0; ii < noncart.dimension(4); ii++) {
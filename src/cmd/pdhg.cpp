@@ -12,6 +12,7 @@
 #include "precond.hpp"
 #include "sdc.hpp"
 #include "sense.hpp"
+#include "volumes.hpp"
 
 using namespace rl;
 
@@ -53,18 +54,17 @@ int main_pdhg(args::Subparser &parser)
   PrimalDualHybridGradient<ReconOp> pdhg{recon, P, reg, its.Get()};
 
   Cropper out_cropper(info.matrix, LastN<3>(sz), info.voxel_size, coreOpts.fov.Get());
-  Cx4 vol(sz);
   Sz3 outSz = out_cropper.size();
-  Cx4 cropped(sz[0], outSz[0], outSz[1], outSz[2]);
-  Cx5 allData = reader.readTensor<Cx5>(HD5::Keys::Noncartesian);
-  Index const volumes = allData.dimension(4);
-  Cx5 out(sz[0], outSz[0], outSz[1], outSz[2], volumes);
-
-  auto const &all_start = Log::Now();
-  for (Index iv = 0; iv < volumes; iv++) {
-    out.chip<4>(iv) = out_cropper.crop4(pdhg.run(CChipMap(allData, iv), τ.Get()));
-  }
-  Log::Print(FMT_STRING("All Volumes: {}"), Log::ToNow(all_start));
-  WriteOutput(out, coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), coreOpts.keepTrajectory, traj);
+  Index const volumes = reader.dimensions<5>(HD5::Keys::Noncartesian)[4];
+  auto const fname = OutName(coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), "h5");
+  HD5::Writer writer(fname);
+  writer.createTensor<Cx, 5>(HD5::Keys::Image, Sz5{sz[0], outSz[0], outSz[1], outSz[2], volumes});
+  ForVolumes(
+    reader,
+    HD5::Keys::Noncartesian,
+    [&](Index, Cx4 const &data) -> Cx4 { return out_cropper.crop4(pdhg.run(data, τ.Get())); },
+    writer,
+    HD5::Keys::Image);
+  WriteTrajectory(writer, coreOpts.keepTrajectory, traj);
   return EXIT_SUCCESS;
 }
@@ -8,6 +8,7 @@
 #include "sdc.hpp"
 #include "sense.hpp"
 #include "tensorOps.hpp"
+#include "volumes.hpp"
 
 using namespace rl;
 
@@ -19,6 +20,7 @@ int main_recon(args::Subparser &parser)
   args::Flag fwd(parser, "", "Apply forward operation", {'f', "fwd"});
   args::ValueFlag<std::string> trajName(parser, "T", "Override trajectory", {"traj"});
   args::ValueFlag<std::string> basisFile(parser, "BASIS", "Read subspace basis from .h5 file", {"basis", 'b'});
+  args::ValueFlag<Index> workers(parser, "W", "Reconstruct W volumes concurrently (1)", {"volume-workers"}, 1);
 
   ParseCommand(parser, coreOpts.iname);
 
@@ -44,34 +46,40 @@ int main_recon(args::Subparser &parser)
     Sz4 const sz = recon->inputDimensions();
     Sz4 const osz = AddFront(traj.matrix(coreOpts.fov.Get()), sz[0]);
 
-    auto const &all_start = Log::Now();
-    auto const images = reader.readTensor<Cx5>(HD5::Keys::Image);
-    Cx4 padded(sz);
-    Cx5 kspace(AddBack(recon->outputDimensions(), volumes));
-    for (Index iv = 0; iv < volumes; iv++) {
-      padded.setZero();
-      Crop(padded, osz) = images.chip<4>(iv);
-      kspace.chip<4>(iv) = recon->forward(padded);
-    }
-    Log::Print(FMT_STRING("All Volumes: {}"), Log::ToNow(all_start));
     auto const fname = OutName(coreOpts.iname.Get(), coreOpts.oname.Get(), "recon", "h5");
     HD5::Writer writer(fname);
+    writer.createTensor<Cx, 5>(HD5::Keys::Noncartesian, AddBack(recon->outputDimensions(), volumes));
+    ForVolumes(
+      reader,
+      HD5::Keys::Image,
+      [&](Index, Cx4 const &image) -> Cx4 {
+        // Pad straight into the operator's input to avoid a copy
+        auto padded = recon->input();
+        padded.setZero();
+        Crop(padded, osz) = image;
+        return recon->forward(padded);
+      },
+      writer,
+      HD5::Keys::Noncartesian);
     traj.write(writer);
-    writer.writeTensor(kspace, HD5::Keys::Noncartesian);
   } else {
-    auto recon = make_recon(coreOpts, sdcOpts, senseOpts, traj, false, reader);
+    auto const setup = make_recon_setup(coreOpts, sdcOpts, senseOpts, traj, reader);
+    auto recon = make_recon(coreOpts, traj, setup, false);
     Sz4 const sz = recon->inputDimensions();
     Sz4 const osz = AMin(AddFront(traj.matrix(coreOpts.fov.Get()), sz[0]), sz);
-    Cx4 vol(sz);
-    Cx5 out(AddBack(osz, volumes));
-    out.setZero();
-    auto const &all_start = Log::Now();
-    for (Index iv = 0; iv < volumes; iv++) {
-      vol = recon->adjoint(reader.readSlab<Cx4>(HD5::Keys::Noncartesian, iv));
-      out.chip<4>(iv) = Crop(vol, osz);
+    auto const fname = OutName(coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), "h5");
+    HD5::Writer writer(fname);
+    writer.createTensor<Cx, 5>(HD5::Keys::Image, AddBack(osz, volumes));
+    std::vector<VolumeFunc> funcs;
+    for (Index iw = 0; iw < std::max<Index>(workers.Get(), 1); iw++) {
+      auto r = iw == 0 ? recon : make_recon(coreOpts, traj, setup, false);
+      funcs.push_back([&, r, vol = Cx4(sz)](Index, Cx4 const &data) mutable -> Cx4 {
+        vol = r->adjoint(data);
+        return Crop(vol, osz);
+      });
     }
-    Log::Print(FMT_STRING("All Volumes: {}"), Log::ToNow(all_start));
-    WriteOutput(out, coreOpts.iname.Get(), coreOpts.oname.Get(), parser.GetCommand().Name(), coreOpts.keepTrajectory, traj);
+    ForVolumes(reader, HD5::Keys::Noncartesian, funcs, writer, HD5::Keys::Image);
+    WriteTrajectory(writer, coreOpts.keepTrajectory, traj);
   }
 
   return EXIT_SUCCESS;
@@ -24,7 +24,7 @@ int main_rss(args::Subparser &parser)
   Index const nC = reader.dimensions<5>(HD5::Keys::Noncartesian)[0];
   auto const sdc = SDC::Choose(sdcOpts, traj, nC, coreOpts.ktype.Get(), coreOpts.osamp.Get());
   auto nufft =
-    make_nufft(traj, coreOpts.ktype.Get(), coreOpts.osamp.Get(), nC, traj.matrix(coreOpts.fov.Get()), basis, sdc, false);
+    make_nufft(traj, coreOpts.ktype.Get(), coreOpts.osamp.Get(), nC, traj.matrix(coreOpts.fov.Get()), basis, sdc);
   Sz4 sz = LastN<4>(nufft->inputDimensions());
 
   Cx5 allData = reader.readTensor<Cx5>(HD5::Keys::Noncartesian);
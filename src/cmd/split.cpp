@@ -26,18 +26,17 @@ int main_split(args::Subparser &parser)
 
   HD5::Reader reader(iname.Get());
   Trajectory traj(reader);
-  Cx4 ks = reader.readTensor<Cx4>(HD5::Keys::Noncartesian);
-  Index const channels = ks.dimension(0);
-  Index volumes = ks.dimension(3);
+  auto const kDims = reader.dimensions<4>(HD5::Keys::Noncartesian);
+  Index const channels = kDims[0];
+  Index volumes = kDims[3];
+  Index firstVol = 0;
   if (vol) {
-    auto info = traj.info();
     if (vol.Get() >= volumes) {
       Log::Fail("Specified volume {} past end of file", vol.Get());
     }
     Log::Print("Selecting volume {}", vol.Get());
+    firstVol = vol.Get();
     volumes = 1;
-    traj = Trajectory(info, traj.points());
-    ks = Cx4(ks.slice(Sz4{0, 0, 0, vol.Get()}, AddBack(FirstN<3>(ks.dimensions()), 1)));
   }
 
   if (trim) {
@@ -46,8 +45,10 @@ int main_split(args::Subparser &parser)
     Re3 points = traj.points();
     points = Re3(points.slice(Sz3{0, trim.Get(), 0}, Sz3{3, points.dimension(1) - trim.Get(), points.dimension(2)}));
     traj = Trajectory(info, points);
-    ks = Cx4(ks.slice(Sz4{0, trim.Get(), 0, 0}, Sz4{channels, points.dimension(1), ks.dimension(2), volumes}));
   }
+  // Only read the selected volume and samples
+  Cx4 ks = reader.readSlice<Cx4>(
+    HD5::Keys::Noncartesian, Sz4{0, trim.Get(), 0, firstVol}, Sz4{channels, traj.nSamples(), kDims[2], volumes});
 
   if (zero) {
     Log::Print(FMT_STRING("Zeroing {} popints"), zero.Get());
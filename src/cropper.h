@@ -5,9 +5,11 @@
 
 namespace rl {
 
-template <typename T, int ND>
-decltype(auto) Crop(Eigen::Tensor<T, ND> &x, Sz<ND> const &sz)
+// Centered slice of a Tensor or TensorMap
+template <typename T>
+decltype(auto) Crop(T &x, Sz<T::NumIndices> const &sz)
 {
+  constexpr auto ND = T::NumIndices;
   Sz<ND> const fullSz = x.dimensions();
   Sz<ND> st;
   for (Index ii = 0; ii < ND; ii++) {
@@ -4,6 +4,7 @@
 #include "cropper.h"
 #include "fft/fft.hpp"
 #include "op/make_grid.hpp"
+#include "op/workspace.hpp"
 #include "tensorOps.hpp"
 #include "threads.hpp"
 
@@ -71,6 +72,31 @@ Cx5 LowRankKernels(Cx5 const &mIn, float const thresh)
   return out;
 }
 
+namespace {
+// Up to this many channels the voxel-wise eigen-decompositions use stack matrices, so do not touch the heap
+int constexpr MaxStackChannels = 64;
+
+// Leading eigenvector and eigenvalue of the channel covariance of one voxel's kernel samples, which are overwritten
+template <int MaxC>
+void LeadingEigen(Eigen::Map<Eigen::MatrixXcf> samples, Cx *vec, float &val)
+{
+  using Matrix = Eigen::Matrix<Cx, Eigen::Dynamic, Eigen::Dynamic, 0, MaxC, MaxC>;
+  using Vector = Eigen::Matrix<Cx, Eigen::Dynamic, 1, 0, MaxC, 1>;
+  Index const nC = samples.rows();
+  Vector const mean = samples.rowwise().mean();
+  samples.colwise() -= mean;
+  Matrix gramian(nC, nC);
+  gramian.noalias() = samples.conjugate() * samples.transpose();
+  gramian /= Cx(nC - 1); // Same normalization as PCA
+  Eigen::SelfAdjointEigenSolver<Matrix> const eig(gramian);
+  float const phase = std::arg(eig.eigenvectors()(0, nC - 1));
+  for (Index ic = 0; ic < nC; ic++) {
+    vec[ic] = std::conj(eig.eigenvectors()(ic, nC - 1) * std::polar(1.f, -phase));
+  }
+  val = std::abs(eig.eigenvalues()(nC - 1));
+}
+} // namespace
+
 Cx4 ESPIRIT(Cx4 const &grid, Sz3 const outSz, Index const kRad, Index const calRad, Index const gap, float const thresh)
 {
   Log::Print(FMT_STRING("ESPIRIT Calibration Radius {} Kernel Radius {}"), calRad, kRad);
@@ -78,60 +104,46 @@ Cx4 ESPIRIT(Cx4 const &grid, Sz3 const outSz, Index const kRad, Index const calR
   Log::Print(FMT_STRING("Calculating k-space kernels"));
   Cx5 const all_kernels = ToKernels(grid, kRad, calRad, gap);
   Cx5 const mini_kernels = LowRankKernels(all_kernels, thresh);
+  Index const nC = mini_kernels.dimension(0);
+  Index const kW = mini_kernels.dimension(1);
   Index const retain = mini_kernels.dimension(4);
 
+  // The kernels are stored (channel, x, y, kernel, z) so that all of them are upsampled in one batched FFT
   Log::Print(FMT_STRING("Upsample last dimension"));
-  Cx4 mix_grid(mini_kernels.dimension(0), mini_kernels.dimension(1), mini_kernels.dimension(2), grid.dimension(3));
-  auto const mix_fft = FFT::Make<4, 1>(mix_grid.dimensions());
-  Cx5 mix_kernels(
-    mini_kernels.dimension(0), mini_kernels.dimension(1), mini_kernels.dimension(2), grid.dimension(3), retain);
+  Index const nZ = grid.dimension(3);
+  Cx5 mix_kernels(nC, kW, kW, retain, nZ);
   mix_kernels.setZero();
-  Cropper const lo_mix(
-    Sz3{mix_grid.dimension(1), mix_grid.dimension(2), mix_grid.dimension(3)},
-    Sz3{mini_kernels.dimension(1), mini_kernels.dimension(2), mini_kernels.dimension(3)});
-  float const scale = (1.f / sqrt(mini_kernels.dimension(1) * mini_kernels.dimension(2) * mini_kernels.dimension(3)));
-  Log::StartProgress(retain, "FFT Kernels");
-  for (Index kk = 0; kk < retain; kk++) {
-    mix_grid.setZero();
-    lo_mix.crop4(mix_grid) = mini_kernels.chip<4>(kk) * mini_kernels.chip<4>(kk).constant(scale);
-    mix_fft->reverse(mix_grid);
-    mix_kernels.chip<4>(kk) = mix_grid;
-    Log::Tick();
-  }
-  Log::StopProgress();
+  Index const zSt = (nZ - (kW - 1)) / 2; // Same as Cropper
+  float const scale = (1.f / sqrt(kW * kW * kW));
+  mix_kernels.slice(Sz5{0, 0, 0, 0, zSt}, Sz5{nC, kW, kW, retain, kW}).device(Threads::GlobalDevice()) =
+    mini_kernels.shuffle(Sz5{0, 1, 2, 4, 3}) * Cx(scale);
+  FFT::Make<5, 1>(mix_kernels.dimensions())->reverse(mix_kernels);
 
   Log::Print(FMT_STRING("Image space Eigenanalysis"));
-  // Do this slice-by-slice
+  // Do this slice-by-slice. The kernels for a slice are stored (channel, kernel, x, y), so one batched FFT transforms
+  // all of them and the samples for each voxel are a contiguous channels x kernels matrix.
   Re3 valsImage(outSz);
-  Cx4 vecsImage(AddFront(outSz, grid.dimension(0)));
-  auto const hiSz = FirstN<3>(grid.dimensions());
-  auto const hiFFT = FFT::Make<3, 2>(hiSz, 1);
-  auto slice_task = [&vecsImage, &valsImage, &mix_kernels, &hiSz, &hiFFT](Index const zz) {
-    // Now do a lot of FFTs
-    Cx4 hi_kernels(vecsImage.dimension(0), vecsImage.dimension(1), vecsImage.dimension(2), mix_kernels.dimension(4));
-    Cx3 hi_slice(hiSz);
-    for (Index kk = 0; kk < mix_kernels.dimension(4); kk++) {
-      Cx3 const mix_kernel = mix_kernels.chip<4>(kk).chip<3>(zz);
-      hi_slice.setZero();
-      Crop(hi_slice, mix_kernel.dimensions()) = mix_kernel;
-      hiFFT->reverse(hi_slice);
-      hi_kernels.chip<3>(kk) = hi_slice;
-    }
+  Cx4 vecsImage(AddFront(outSz, nC));
+  Sz4 const hiSz{nC, retain, grid.dimension(1), grid.dimension(2)};
+  auto const hiFFT = FFT::Make<4, 2>(hiSz, 1);
+  auto slice_task = [&](Index const zz) {
+    Workspace::Lease<Cx4> hi(hiSz);
+    hi->setZero();
+    Crop(*hi, Sz4{nC, retain, kW, kW}) = mix_kernels.chip<4>(zz).shuffle(Sz4{0, 3, 1, 2});
+    hiFFT->reverse(*hi);
 
-    // Now voxel-wise covariance
-    for (Index yy = 0; yy < hi_slice.dimension(2); yy++) {
-      for (Index xx = 0; xx < hi_slice.dimension(1); xx++) {
-        Cx2 const samples = hi_kernels.chip<2>(yy).template chip<1>(xx);
-        auto const pcs = PCA(CollapseToConstMatrix(samples), 1);
-        float const phase = std::arg(pcs.vecs(0, 0));
-        for (Index ic = 0; ic < samples.dimension(0); ic++) {
-          vecsImage(ic, xx, yy, zz) = std::conj(pcs.vecs(ic, 0) * std::polar(1.f, -phase));
+    for (Index yy = 0; yy < hiSz[3]; yy++) {
+      for (Index xx = 0; xx < hiSz[2]; xx++) {
+        Eigen::Map<Eigen::MatrixXcf> samples(hi->data() + (xx + yy * hiSz[2]) * nC * retain, nC, retain);
+        if (nC <= MaxStackChannels) {
+          LeadingEigen<MaxStackChannels>(samples, &vecsImage(0, xx, yy, zz), valsImage(xx, yy, zz));
+        } else {
+          LeadingEigen<Eigen::Dynamic>(samples, &vecsImage(0, xx, yy, zz), valsImage(xx, yy, zz));
         }
-        valsImage(xx, yy, zz) = pcs.vals[0];
       }
     }
   };
-  Threads::For(slice_task, mix_kernels.dimension(3), "Covariance");
+  Threads::For(slice_task, nZ, "Covariance");
 
   Log::Print(FMT_STRING("Finished ESPIRIT"));
   return vecsImage;
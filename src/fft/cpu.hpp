@@ -4,73 +4,89 @@
 
 #include "../log.hpp"
 #include "../tensorOps.hpp"
+#include "../threads.hpp"
 
 #include "fftw3.h"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace rl {
 namespace FFT {
 
+// Records a lookup in the plan registry, see Plans
+void CountPlan(bool const hit);
+
+/*! FFTW plans and FFT-shift phase factors for one shape. Executing a plan on another array with fftwf_execute_dft is
+ *  valid as long as it has the same alignment, so plans are shared through a registry (see Registered) between all the
+ *  FFTs with the same dimensions, active region, thread count and alignment.
+ */
 template <int TRank, int FRank>
-struct CPU final : FFT<TRank, FRank>
+struct Plans
 {
-  using Tensor = typename FFT<TRank, FRank>::Tensor;
-  using TensorDims = typename FFT<TRank, FRank>::TensorDims;
   using TensorMap = typename FFT<TRank, FRank>::TensorMap;
-  /*! Will allocate a workspace during planning
-   */
-  CPU(TensorDims const &dims, Index const nThreads)
-    : dims_{dims}
-    , threaded_{nThreads > 1}
-  {
-    Tensor ws(dims);
-    plan(ws, nThreads);
-  }
+  using TensorDims = typename FFT<TRank, FRank>::TensorDims;
+  using ActiveDims = typename FFT<TRank, FRank>::ActiveDims;
 
-  CPU(TensorMap ws, Index const nThreads)
-    : dims_(ws.dimensions())
-    , threaded_{nThreads > 1}
-  {
-    plan(ws, nThreads);
-  }
+  Cx1 phase;
+  Re1 sign; // Only set if the phase is real
+  float scale;
+  Index N, nVox;
 
-  void plan(TensorMap ws, Index const nThreads)
+  Plans(TensorMap ws, ActiveDims const &active, bool const pruned, Index const nThreads)
+    : dims_(ws.dimensions())
+    , active_{active}
+    , pruned_{pruned}
   {
     std::array<int, FRank> sz;
-    N_ = 1;
-    nVox_ = 1;
+    N = 1;
+    nVox = 1;
     // Process the two different kinds of dimensions - howmany / FFT
     {
       constexpr int FStart = TRank - FRank;
       int ii = 0;
       for (; ii < FStart; ii++) {
-        N_ *= ws.dimension(ii);
+        N *= ws.dimension(ii);
       }
       std::array<Cx1, FRank> phases;
 
       for (; ii < TRank; ii++) {
         sz[ii - FStart] = ws.dimension(ii);
-        nVox_ *= sz[ii - FStart];
+        nVox *= sz[ii - FStart];
         phases[ii - FStart] = Phase(sz[ii - FStart]); // Prep FFT phase factors
       }
-      scale_ = 1. / sqrt(nVox_);
+      scale = 1. / sqrt(nVox);
       Eigen::Tensor<Cx, FRank> tempPhase_(LastN<FRank>(dims_));
       tempPhase_.device(Threads::GlobalDevice()) = startPhase(phases);
-      phase_.resize(Sz1{nVox_});
-      phase_.device(Threads::GlobalDevice()) = tempPhase_.reshape(Sz1{nVox_});
+      phase.resize(Sz1{nVox});
+      phase.device(Threads::GlobalDevice()) = tempPhase_.reshape(Sz1{nVox});
+      // If every size is a multiple of 4 the phase is a checkerboard of ±1 and can be applied to the real and imaginary
+      // parts separately
+      if (std::all_of(sz.begin(), sz.end(), [](int s) { return s % 4 == 0; })) {
+        sign.resize(Sz1{nVox});
+        sign.device(Threads::GlobalDevice()) = phase.real();
+      }
     }
 
     auto ptr = reinterpret_cast<fftwf_complex *>(ws.data());
-    Log::Print(FMT_STRING("Planning {} {} FFTs with {} threads"), N_, fmt::join(sz, "x"), nThreads);
+    Log::Print(FMT_STRING("Planning {} {} FFTs with {} threads"), N, fmt::join(sz, "x"), nThreads);
 
     // FFTW is row-major. Reverse dims as per
     // http://www.fftw.org/fftw3_doc/Column_002dmajor-Format.html#Column_002dmajor-Format
     std::reverse(sz.begin(), sz.end());
     auto const start = Log::Now();
     fftwf_plan_with_nthreads(nThreads);
+    if (pruned_) {
+      planPruned(ws);
+      Log::Print<Log::Level::High>(FMT_STRING("FFT planning took {}"), Log::ToNow(start));
+      return;
+    }
     forward_plan_ =
-      fftwf_plan_many_dft(FRank, sz.data(), N_, ptr, nullptr, N_, 1, ptr, nullptr, N_, 1, FFTW_FORWARD, FFTW_MEASURE);
+      fftwf_plan_many_dft(FRank, sz.data(), N, ptr, nullptr, N, 1, ptr, nullptr, N, 1, FFTW_FORWARD, FFTW_MEASURE);
     reverse_plan_ =
-      fftwf_plan_many_dft(FRank, sz.data(), N_, ptr, nullptr, N_, 1, ptr, nullptr, N_, 1, FFTW_BACKWARD, FFTW_MEASURE);
+      fftwf_plan_many_dft(FRank, sz.data(), N, ptr, nullptr, N, 1, ptr, nullptr, N, 1, FFTW_BACKWARD, FFTW_MEASURE);
 
     if (forward_plan_ == NULL) {
       Log::Fail(FMT_STRING("Could not create forward FFT Planned"));
@@ -82,32 +98,75 @@ struct CPU final : FFT<TRank, FRank>
     Log::Print<Log::Level::High>(FMT_STRING("FFT planning took {}"), Log::ToNow(start));
   }
 
-  ~CPU()
+  // Plans a 1D transform along each axis that covers only the lines passing through the active region
+  void planPruned(TensorMap ws)
   {
-    fftwf_destroy_plan(forward_plan_);
-    fftwf_destroy_plan(reverse_plan_);
+    constexpr int FStart = TRank - FRank;
+    std::array<Index, FRank> stride, lo;
+    Index s = N;
+    for (int ii = 0; ii < FRank; ii++) {
+      stride[ii] = s;
+      s *= dims_[FStart + ii];
+      lo[ii] = (dims_[FStart + ii] - active_[ii] + 1) / 2; // Same as PadOp
+    }
+    /* Going forward, the axes before the current one have already been transformed so are dense, and the axes after it
+     * are still zero outside the active region. Going in reverse the same holds with the axes in the opposite order.
+     */
+    auto ptr = reinterpret_cast<fftwf_complex *>(ws.data());
+    for (int ia = 0; ia < FRank; ia++) {
+      fftwf_iodim64 dim{.n = dims_[FStart + ia], .is = stride[ia], .os = stride[ia]};
+      std::vector<fftwf_iodim64> many{{.n = N, .is = 1, .os = 1}};
+      offsets_[ia] = 0;
+      for (int ib = 0; ib < FRank; ib++) {
+        if (ib < ia) {
+          many.push_back({.n = dims_[FStart + ib], .is = stride[ib], .os = stride[ib]});
+        } else if (ib > ia) {
+          many.push_back({.n = active_[ib], .is = stride[ib], .os = stride[ib]});
+          offsets_[ia] += lo[ib] * stride[ib];
+        }
+      }
+      auto const p = ptr + offsets_[ia];
+      forward_axes_[ia] = fftwf_plan_guru64_dft(1, &dim, many.size(), many.data(), p, p, FFTW_FORWARD, FFTW_MEASURE);
+      reverse_axes_[ia] = fftwf_plan_guru64_dft(1, &dim, many.size(), many.data(), p, p, FFTW_BACKWARD, FFTW_MEASURE);
+      if (forward_axes_[ia] == NULL || reverse_axes_[ia] == NULL) {
+        Log::Fail(FMT_STRING("Could not create pruned FFT plans for axis {}"), ia);
+      }
+    }
   }
 
-  void forward(TensorMap x) const //!< Image space to k-space
+  ~Plans()
   {
-    for (Index ii = 0; ii < TRank; ii++) {
-      assert(x.dimension(ii) == dims_[ii]);
+    if (pruned_) {
+      for (int ia = 0; ia < FRank; ia++) {
+        fftwf_destroy_plan(forward_axes_[ia]);
+        fftwf_destroy_plan(reverse_axes_[ia]);
+      }
+    } else {
+      fftwf_destroy_plan(forward_plan_);
+      fftwf_destroy_plan(reverse_plan_);
     }
-    applyPhase(x, 1.f, true);
-    auto ptr = reinterpret_cast<fftwf_complex *>(x.data());
-    fftwf_execute_dft(forward_plan_, ptr, ptr);
-    applyPhase(x, scale_, true);
   }
 
-  void reverse(TensorMap x) const //!< K-space to image space
+  void forward(fftwf_complex *ptr) const
   {
-    for (Index ii = 0; ii < TRank; ii++) {
-      assert(x.dimension(ii) == dims_[ii]);
+    if (pruned_) {
+      for (int ia = 0; ia < FRank; ia++) {
+        fftwf_execute_dft(forward_axes_[ia], ptr + offsets_[ia], ptr + offsets_[ia]);
+      }
+    } else {
+      fftwf_execute_dft(forward_plan_, ptr, ptr);
+    }
+  }
+
+  void reverse(fftwf_complex *ptr) const
+  {
+    if (pruned_) {
+      for (int ia = FRank - 1; ia >= 0; ia--) {
+        fftwf_execute_dft(reverse_axes_[ia], ptr + offsets_[ia], ptr + offsets_[ia]);
+      }
+    } else {
+      fftwf_execute_dft(reverse_plan_, ptr, ptr);
     }
-    applyPhase(x, scale_, false);
-    auto ptr = reinterpret_cast<fftwf_complex *>(x.data());
-    fftwf_execute_dft(reverse_plan_, ptr, ptr);
-    applyPhase(x, 1.f, false);
   }
 
 private:
@@ -144,10 +203,145 @@ private:
     }
   }
 
+  TensorDims dims_;
+  ActiveDims active_;
+  bool pruned_;
+  fftwf_plan forward_plan_, reverse_plan_;
+  std::array<fftwf_plan, FRank> forward_axes_, reverse_axes_;
+  std::array<Index, FRank> offsets_;
+};
+
+/*
+ * Returns the plans for an FFT, shared with every other FFT in this process with the same shape, thread count and
+ * alignment. The workspace is only requested, and planned on, if there are no such plans yet. The registry holds the most
+ * recently used plans as well, so operators that are rebuilt every iteration do not re-plan each time.
+ */
+template <int TRank, int FRank>
+auto Registered(
+  typename Plans<TRank, FRank>::TensorDims const &dims,
+  typename Plans<TRank, FRank>::ActiveDims const &active,
+  bool const pruned,
+  Index const nThreads,
+  int const alignment,
+  std::function<typename Plans<TRank, FRank>::TensorMap()> const &ws) -> std::shared_ptr<Plans<TRank, FRank> const>
+{
+  using P = Plans<TRank, FRank>;
+  struct Entry
+  {
+    typename P::TensorDims dims;
+    typename P::ActiveDims active;
+    bool pruned;
+    Index nThreads;
+    int alignment;
+    std::weak_ptr<P const> plans;
+  };
+  Index constexpr KeepRecent = 4;
+  static std::mutex mutex;
+  static std::vector<Entry> entries;
+  static std::deque<std::shared_ptr<P const>> recent;
+  std::scoped_lock lock(mutex);
+  std::erase_if(entries, [](Entry const &e) { return e.plans.expired(); });
+  for (auto const &e : entries) {
+    if (e.dims == dims && e.pruned == pruned && (!pruned || e.active == active) && e.nThreads == nThreads &&
+        e.alignment == alignment) {
+      if (auto p = e.plans.lock()) {
+        CountPlan(true);
+        return p;
+      }
+    }
+  }
+  CountPlan(false);
+  auto p = std::make_shared<P const>(ws(), active, pruned, nThreads);
+  entries.push_back(Entry{.dims = dims, .active = active, .pruned = pruned, .nThreads = nThreads, .alignment = alignment, .plans = p});
+  recent.push_back(p);
+  if (Index(recent.size()) > KeepRecent) {
+    recent.pop_front();
+  }
+  return p;
+}
+
+template <int TRank, int FRank>
+struct CPU final : FFT<TRank, FRank>
+{
+  using Tensor = typename FFT<TRank, FRank>::Tensor;
+  using TensorDims = typename FFT<TRank, FRank>::TensorDims;
+  using TensorMap = typename FFT<TRank, FRank>::TensorMap;
+  using ActiveDims = typename FFT<TRank, FRank>::ActiveDims;
+  /*! Will allocate a workspace during planning, unless the plans are already registered
+   */
+  CPU(TensorDims const &dims, Index const nThreads)
+    : dims_{dims}
+    , threaded_{nThreads > 1}
+  {
+    Tensor ws;
+    plans_ = Registered<TRank, FRank>(dims, ActiveDims(), false, nThreads, 0, [&]() {
+      ws.resize(dims);
+      return TensorMap(ws.data(), dims);
+    });
+  }
+
+  CPU(TensorMap ws, Index const nThreads)
+    : dims_(ws.dimensions())
+    , threaded_{nThreads > 1}
+  {
+    plans_ = Registered<TRank, FRank>(dims_, ActiveDims(), false, nThreads, Alignment(ws), [&]() { return ws; });
+  }
+
+  /*! Pruned FFT for data that is zero outside a central active region, e.g. a zero-padded image. The transform is done
+   *  one axis at a time, skipping lines that lie entirely outside the active region. The forward transform is exact if
+   *  the data is zero outside the region, the reverse transform is only correct inside it. If imagePhase is false the
+   *  image-space half of the FFT shift is left to the caller, see ApodizePadOp.
+   */
+  CPU(TensorMap ws, ActiveDims const &active, bool const imagePhase, Index const nThreads)
+    : dims_(ws.dimensions())
+    , imagePhase_{imagePhase}
+    , threaded_{nThreads > 1}
+  {
+    plans_ = Registered<TRank, FRank>(dims_, active, true, nThreads, Alignment(ws), [&]() { return ws; });
+  }
+
+  void forward(TensorMap x) const //!< Image space to k-space
+  {
+    for (Index ii = 0; ii < TRank; ii++) {
+      assert(x.dimension(ii) == dims_[ii]);
+    }
+    if (imagePhase_) {
+      applyPhase(x, 1.f, true);
+    }
+    plans_->forward(reinterpret_cast<fftwf_complex *>(x.data()));
+    applyPhase(x, plans_->scale, true);
+  }
+
+  void reverse(TensorMap x) const //!< K-space to image space
+  {
+    for (Index ii = 0; ii < TRank; ii++) {
+      assert(x.dimension(ii) == dims_[ii]);
+    }
+    applyPhase(x, plans_->scale, false);
+    plans_->reverse(reinterpret_cast<fftwf_complex *>(x.data()));
+    if (imagePhase_) {
+      applyPhase(x, 1.f, false);
+    }
+  }
+
+private:
+  static auto Alignment(TensorMap ws) -> int { return fftwf_alignment_of(reinterpret_cast<float *>(ws.data())); }
+
   void applyPhase(TensorMap x, float const scale, bool const fwd) const
   {
-    Sz2 rshP{1, nVox_}, brdP{N_, 1}, rshX{N_, nVox_};
-    auto const rbPhase = phase_.reshape(rshP).broadcast(brdP);
+    if (plans_->sign.size()) {
+      // ±1 is its own inverse, so the direction does not matter
+      Eigen::TensorMap<Re2> xf(reinterpret_cast<float *>(x.data()), Sz2{2 * plans_->N, plans_->nVox});
+      auto const rbSign = plans_->sign.reshape(Sz2{1, plans_->nVox}).broadcast(Sz2{2 * plans_->N, 1});
+      if (threaded_) {
+        xf.device(Threads::GlobalDevice()) = xf * rbSign.constant(scale) * rbSign;
+      } else {
+        xf = xf * rbSign.constant(scale) * rbSign;
+      }
+      return;
+    }
+    Sz2 rshP{1, plans_->nVox}, brdP{plans_->N, 1}, rshX{plans_->N, plans_->nVox};
+    auto const rbPhase = plans_->phase.reshape(rshP).broadcast(brdP);
     auto xr = x.reshape(rshX);
     if (threaded_) {
       if (fwd) {
@@ -165,10 +359,8 @@ private:
   }
 
   TensorDims dims_;
-  Cx1 phase_;
-  fftwf_plan forward_plan_, reverse_plan_;
-  float scale_;
-  Index N_, nVox_;
+  std::shared_ptr<Plans<TRank, FRank> const> plans_;
+  bool imagePhase_ = true;
   bool threaded_;
 };
 
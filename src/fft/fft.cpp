@@ -6,6 +6,7 @@
 #include "../tensorOps.hpp"
 #include "../threads.hpp"
 #include "fftw3.h"
+#include <atomic>
 #include <filesystem>
 #include <pwd.h>
 #include <sys/types.h>
@@ -21,9 +22,28 @@ std::filesystem::path WisdomPath()
   return std::filesystem::path(homedir) / ".riesling-wisdom";
 }
 
+namespace {
+// FFTW hands its parallel loops to this instead of starting a thread team of its own
+void ParallelLoop(void *(*work)(char *), char *jobdata, size_t elsize, int njobs, void *)
+{
+  Threads::Parallel([&](Index const ij) { work(jobdata + ij * elsize); }, njobs);
+}
+
+std::atomic<Index> planHits = 0, planMisses = 0;
+} // namespace
+
+void CountPlan(bool const hit)
+{
+  Index const hits = hit ? ++planHits : planHits.load();
+  Index const misses = hit ? planMisses.load() : ++planMisses;
+  Log::Print<Log::Level::High>(
+    FMT_STRING("FFT plan registry {}, {} hits from {} lookups"), hit ? "hit" : "miss", hits, hits + misses);
+}
+
 void Start()
 {
   fftwf_init_threads();
+  fftwf_threads_set_callback(ParallelLoop, nullptr);
   fftwf_make_planner_thread_safe();
   fftwf_set_timelimit(60.0);
   auto const wp = WisdomPath();
@@ -36,6 +56,10 @@ void Start()
 
 void End()
 {
+  if (Index const lookups = planHits + planMisses; lookups > 0) {
+    Log::Print(
+      FMT_STRING("FFT plan registry hit rate {:.0f}% ({} of {} lookups)"), 100.f * planHits / lookups, planHits.load(), lookups);
+  }
   auto const &wp = WisdomPath();
   if (fftwf_export_wisdom_to_filename(wp.string().c_str())) {
     Log::Print(FMT_STRING("Saved wisdom to {}"), wp.string());
@@ -86,6 +110,7 @@ template std::shared_ptr<FFT<3, 1>> Make(typename FFT<3, 1>::TensorDims const &,
 template std::shared_ptr<FFT<4, 1>> Make(typename FFT<4, 1>::TensorDims const &, Index const);
 template std::shared_ptr<FFT<5, 3>> Make(typename FFT<5, 3>::TensorDims const &, Index const);
 template std::shared_ptr<FFT<3, 2>> Make(typename FFT<3, 2>::TensorDims const &, Index const);
+template std::shared_ptr<FFT<5, 1>> Make(typename FFT<5, 1>::TensorDims const &, Index const);
 
 template <int TRank, int FFTRank>
 std::shared_ptr<FFT<TRank, FFTRank>> Make(typename FFT<TRank, FFTRank>::TensorMap ws, Index const inThreads)
@@ -101,5 +126,23 @@ template std::shared_ptr<FFT<3, 1>> Make(typename FFT<3, 1>::TensorMap, Index co
 template std::shared_ptr<FFT<4, 2>> Make(typename FFT<4, 2>::TensorMap, Index const);
 template std::shared_ptr<FFT<5, 3>> Make(typename FFT<5, 3>::TensorMap, Index const);
 
+template <int TRank, int FFTRank>
+std::shared_ptr<FFT<TRank, FFTRank>> Make(
+  typename FFT<TRank, FFTRank>::TensorMap ws,
+  typename FFT<TRank, FFTRank>::ActiveDims const &active,
+  bool const imagePhase,
+  Index const inThreads)
+{
+  Index const nThreads = (inThreads > 0) ? inThreads : Threads::GlobalThreadCount();
+  return std::make_shared<CPU<TRank, FFTRank>>(ws, active, imagePhase, nThreads);
+}
+
+template std::shared_ptr<FFT<3, 1>>
+Make(typename FFT<3, 1>::TensorMap, typename FFT<3, 1>::ActiveDims const &, bool const, Index const);
+template std::shared_ptr<FFT<4, 2>>
+Make(typename FFT<4, 2>::TensorMap, typename FFT<4, 2>::ActiveDims const &, bool const, Index const);
+template std::shared_ptr<FFT<5, 3>>
+Make(typename FFT<5, 3>::TensorMap, typename FFT<5, 3>::ActiveDims const &, bool const, Index const);
+
 } // namespace FFT
 } // namespace rl
@@ -15,6 +15,7 @@ struct FFT
   using Tensor = Eigen::Tensor<Cx, TensorRank>;
   using TensorDims = typename Tensor::Dimensions;
   using TensorMap = Eigen::TensorMap<Tensor>;
+  using ActiveDims = Eigen::DSizes<Index, FFTRank>;
 
   virtual ~FFT() {}
 
@@ -35,5 +36,16 @@ template <int TRank, int FFTRank>
 std::shared_ptr<FFT<TRank, FFTRank>>
 Make(typename FFT<TRank, FFTRank>::TensorMap ws, Index const threads = 0);
 
+/* Pruned FFT for data that is only non-zero in a central region of size active, i.e. a zero-padded image. Lines that
+ * lie entirely outside the region are skipped. The reverse transform is only correct inside the region. If imagePhase
+ * is false the image-space half of the FFT shift is not applied, so that the caller can fuse it with the padding.
+ */
+template <int TRank, int FFTRank>
+std::shared_ptr<FFT<TRank, FFTRank>> Make(
+  typename FFT<TRank, FFTRank>::TensorMap ws,
+  typename FFT<TRank, FFTRank>::ActiveDims const &active,
+  bool const imagePhase = true,
+  Index const threads = 0);
+
 } // namespace FFT
 }
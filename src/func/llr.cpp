@@ -1,6 +1,7 @@
 #include "llr.hpp"
 
 #include "algo/decomp.hpp"
+#include "op/workspace.hpp"
 #include "tensorOps.hpp"
 #include "threads.hpp"
 #include <cmath>
@@ -56,7 +57,8 @@ auto LLR::operator()(float const α, Eigen::TensorMap<Cx4 const> x) const -> Cx4
           stP[ii + 1] = std::clamp(stW[ii + 1] - inset, 0L, x.dimension(ii + 1) - patchSize);
           stW2[ii + 1] = stW[ii + 1] - stP[ii + 1];
         }
-        Cx4 patchTensor = x.slice(stP, szP);
+        auto patchTensor = Workspace::ThreadScratch<Cx4>(szP);
+        patchTensor = x.slice(stP, szP);
         auto patch = CollapseToMatrix(patchTensor);
         auto const svd = SVD<Cx>(patch, true, false);
         // Soft-threhold svals
@@ -8,6 +8,21 @@
 namespace rl {
 namespace HD5 {
 
+namespace {
+Compression compression;
+}
+
+void SetCompression(Compression const c)
+{
+  if (c.level < 0 || c.level > 9) {
+    Log::Fail(FMT_STRING("Deflate level {} must be between 0 and 9"), c.level);
+  }
+  compression = c;
+  Log::Print<Log::Level::High>(FMT_STRING("HDF5 deflate level {} shuffle {}"), c.level, c.shuffle);
+}
+
+auto GetCompression() -> Compression { return compression; }
+
 void Init()
 {
   static bool NeedsInit = true;
@@ -24,6 +24,14 @@ Handle type()
   return type_impl(type_tag<T>{});
 }
 
+struct Compression
+{
+  int level = 2;        // Deflate level, 0 disables compression
+  bool shuffle = false; // Byte-shuffle filter, helps deflate with floating-point data
+};
+void SetCompression(Compression const c);
+auto GetCompression() -> Compression;
+
 void Init();
 Handle InfoType();
 void CheckInfoType(Handle h);
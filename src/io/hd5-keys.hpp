@@ -26,5 +26,28 @@ std::string const SENSE = "sense";
 std::string const Trajectory = "trajectory";
 } // namespace Keys
 
+/*
+ * How datasets are split into chunks on disk. Whole keeps the entire dataset in one chunk (shrunk to stay under 4 GB),
+ * Volume uses one chunk per entry of the outermost dimension, Traces uses blocks of whole traces within a volume so
+ * that subsets of traces can be read and written without touching the rest.
+ */
+enum struct Chunking
+{
+  Whole,
+  Volume,
+  Traces
+};
+
+inline auto ChunkingFor(std::string const &label) -> Chunking
+{
+  if (label == Keys::Noncartesian) {
+    return Chunking::Traces;
+  } else if (label == Keys::Image || label == Keys::Cartesian || label == Keys::Channels) {
+    return Chunking::Volume;
+  } else {
+    return Chunking::Whole;
+  }
+}
+
 } // namespace HD5
 }
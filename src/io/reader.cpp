@@ -129,6 +129,61 @@ void load_tensor_slab(
   }
 }
 
+template <typename Scalar, int ND>
+void load_tensor_slice(
+  Handle const &parent,
+  std::string const &name,
+  Eigen::DSizes<Index, ND> const &start,
+  Eigen::DSizes<Index, ND> const &stride,
+  Eigen::Tensor<Scalar, ND> &tensor)
+{
+  hid_t dset = H5Dopen(parent, name.c_str(), H5P_DEFAULT);
+  if (dset < 0) {
+    Log::Fail(FMT_STRING("Could not open tensor '{}'"), name);
+  }
+  hid_t ds = H5Dget_space(dset);
+  auto const rank = H5Sget_simple_extent_ndims(ds);
+  if (rank != ND) {
+    Log::Fail(FMT_STRING("Tensor {}: Requested rank {}, on-disk rank {}"), name, ND, rank);
+  }
+
+  std::array<hsize_t, ND> dims;
+  H5Sget_simple_extent_dims(ds, dims.data(), NULL);
+  std::reverse(dims.begin(), dims.end()); // HD5=row-major, Eigen=col-major
+  for (int ii = 0; ii < ND; ii++) {
+    if (start[ii] < 0 || stride[ii] < 1 || tensor.dimension(ii) < 1 ||
+        start[ii] + (tensor.dimension(ii) - 1) * stride[ii] >= (Index)dims[ii]) {
+      Log::Fail(
+        FMT_STRING("Tensor {}: slice start {} count {} stride {} does not fit dimensions {}"),
+        name,
+        fmt::join(start, ","),
+        fmt::join(tensor.dimensions(), ","),
+        fmt::join(stride, ","),
+        fmt::join(dims, ","));
+    }
+  }
+
+  std::array<hsize_t, ND> h5_start, h5_stride, h5_count;
+  std::reverse_copy(start.begin(), start.end(), h5_start.begin());
+  std::reverse_copy(stride.begin(), stride.end(), h5_stride.begin());
+  std::reverse_copy(tensor.dimensions().begin(), tensor.dimensions().end(), h5_count.begin());
+  auto status = H5Sselect_hyperslab(ds, H5S_SELECT_SET, h5_start.data(), h5_stride.data(), h5_count.data(), NULL);
+  auto const mem_ds = H5Screate_simple(ND, h5_count.data(), NULL);
+  status = H5Dread(dset, type<Scalar>(), mem_ds, ds, H5P_DEFAULT, tensor.data());
+  H5Sclose(mem_ds);
+  H5Sclose(ds);
+  H5Dclose(dset);
+  if (status < 0) {
+    Log::Fail(FMT_STRING("Tensor {}: Error reading slice. HD5 Message: {}"), name, GetError());
+  } else {
+    Log::Print<Log::Level::High>(
+      FMT_STRING("Read slice start {} count {} from tensor {}"),
+      fmt::join(start, ","),
+      fmt::join(tensor.dimensions(), ","),
+      name);
+  }
+}
+
 template <typename Scalar, int ND>
 Eigen::Tensor<Scalar, ND> load_tensor(Handle const &parent, std::string const &name)
 {
@@ -189,7 +244,11 @@ Reader::Reader(std::string const &fname)
     Log::Fail(FMT_STRING("File does not exist: {}"), fname);
   }
   Init();
-  handle_ = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  // Close any datasets still open when the file is closed, so the file can be rewritten afterwards
+  auto const fapl = H5Pcreate(H5P_FILE_ACCESS);
+  H5Pset_fclose_degree(fapl, H5F_CLOSE_STRONG);
+  handle_ = H5Fopen(fname.c_str(), H5F_ACC_RDONLY, fapl);
+  H5Pclose(fapl);
   if (handle_ < 0) {
     Log::Fail(FMT_STRING("Failed to open {}"), fname);
   }
@@ -253,6 +312,34 @@ auto Reader::readSlab(std::string const &label, Index const ind) const -> T
 template auto Reader::readSlab<Cx3>(std::string const &, Index const) const -> Cx3;
 template auto Reader::readSlab<Cx4>(std::string const &, Index const) const -> Cx4;
 
+template <typename T>
+auto Reader::readSlice(
+  std::string const &label,
+  Eigen::DSizes<Index, T::NumDimensions> const &start,
+  Eigen::DSizes<Index, T::NumDimensions> const &count,
+  Eigen::DSizes<Index, T::NumDimensions> const &stride) const -> T
+{
+  T result(count);
+  load_tensor_slice(handle_, label, start, stride, result);
+  return result;
+}
+
+template <typename T>
+auto Reader::readSlice(
+  std::string const &label,
+  Eigen::DSizes<Index, T::NumDimensions> const &start,
+  Eigen::DSizes<Index, T::NumDimensions> const &count) const -> T
+{
+  Eigen::DSizes<Index, T::NumDimensions> stride;
+  stride.fill(1);
+  return readSlice<T>(label, start, count, stride);
+}
+
+template auto Reader::readSlice<Cx4>(std::string const &, Sz4 const &, Sz4 const &, Sz4 const &) const -> Cx4;
+template auto Reader::readSlice<Cx5>(std::string const &, Sz5 const &, Sz5 const &, Sz5 const &) const -> Cx5;
+template auto Reader::readSlice<Cx4>(std::string const &, Sz4 const &, Sz4 const &) const -> Cx4;
+template auto Reader::readSlice<Cx5>(std::string const &, Sz5 const &, Sz5 const &) const -> Cx5;
+
 template <typename Derived>
 auto Reader::readMatrix(std::string const &label) const -> Derived
 {
@@ -32,6 +32,17 @@ struct Reader
   auto readTensor(std::string const &label) const -> T;
   template <typename T>
   auto readSlab(std::string const &label, Index const ind) const -> T;
+  template <typename T> // Read count elements from start, stepping by stride, in every dimension
+  auto readSlice(
+    std::string const &label,
+    Eigen::DSizes<Index, T::NumDimensions> const &start,
+    Eigen::DSizes<Index, T::NumDimensions> const &count,
+    Eigen::DSizes<Index, T::NumDimensions> const &stride) const -> T;
+  template <typename T>
+  auto readSlice(
+    std::string const &label,
+    Eigen::DSizes<Index, T::NumDimensions> const &start,
+    Eigen::DSizes<Index, T::NumDimensions> const &count) const -> T;
   template <typename Derived>
   auto readMatrix(std::string const &label) const -> Derived;
 
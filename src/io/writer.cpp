@@ -2,11 +2,68 @@
 
 #include "io/hd5-core.hpp"
 #include "log.hpp"
+#include <algorithm>
 #include <hdf5.h>
 
 namespace rl {
 namespace HD5 {
 
+template <typename Scalar, int ND>
+void shrink_chunk(hsize_t chunk_dims[ND])
+{
+  // Try to stop chunk dimension going over 4 gig
+  Index sizeInBytes = sizeof(Scalar);
+  for (Index ii = 0; ii < ND; ii++) {
+    sizeInBytes *= chunk_dims[ii];
+  }
+  Index dimToShrink = 0;
+  while (sizeInBytes > (1L << 32L)) {
+    if (chunk_dims[dimToShrink] > 1) {
+      chunk_dims[dimToShrink] /= 2;
+      sizeInBytes /= 2;
+    }
+    dimToShrink = (dimToShrink + 1) % ND;
+  }
+}
+
+/*
+ * Creates the dataset property list with the chunk layout for this dataset and the global compression settings.
+ * If slabs is true the chunks never span more than one entry of the outermost dimension.
+ */
+template <typename Scalar, int ND>
+hid_t create_plist(std::string const &name, hsize_t const ds_dims[ND], bool const slabs)
+{
+  hsize_t chunk_dims[ND];
+  std::copy_n(ds_dims, ND, chunk_dims);
+  auto const chunking = ChunkingFor(name);
+  if (chunking == Chunking::Volume || slabs) {
+    chunk_dims[0] = 1;
+  }
+  if (chunking == Chunking::Traces && ND > 2) {
+    // Aim for chunks of about 1 MB, which fits the default HDF5 chunk cache
+    Index const traceBytes = ds_dims[ND - 1] * ds_dims[ND - 2] * sizeof(Scalar);
+    std::fill_n(chunk_dims, ND - 3, 1);
+    chunk_dims[ND - 3] = std::clamp<Index>((1L << 20L) / traceBytes, 1, ds_dims[ND - 3]);
+  }
+  shrink_chunk<Scalar, ND>(chunk_dims);
+
+  auto const c = GetCompression();
+  auto const plist = H5Pcreate(H5P_DATASET_CREATE);
+  herr_t status = H5Pset_chunk(plist, ND, chunk_dims);
+  if (c.shuffle) {
+    status = H5Pset_shuffle(plist);
+  }
+  if (c.level > 0) {
+    status = H5Pset_deflate(plist, c.level);
+  }
+  if (status < 0) {
+    Log::Fail(FMT_STRING("Could not set layout for tensor {}. Error {}"), name, HD5::GetError());
+  }
+  Log::Print<Log::Level::Debug>(
+    FMT_STRING("Tensor {} chunks {} deflate {} shuffle {}"), name, fmt::join(chunk_dims, ","), c.level, c.shuffle);
+  return plist;
+}
+
 template <typename Scalar, int ND>
 void store_tensor(Handle const &parent, std::string const &name, Eigen::Tensor<Scalar, ND> const &data)
 {
@@ -18,25 +75,12 @@ void store_tensor(Handle const &parent, std::string const &name, Eigen::Tensor<S
   }
 
   herr_t status;
-  hsize_t ds_dims[ND], chunk_dims[ND];
+  hsize_t ds_dims[ND];
   // HD5=row-major, Eigen=col-major, so need to reverse the dimensions
   std::copy_n(data.dimensions().rbegin(), ND, ds_dims);
-  std::copy_n(ds_dims, ND, chunk_dims);
-  // Try to stop chunk dimension going over 4 gig
-  Index sizeInBytes = Product(data.dimensions()) * sizeof(Scalar);
-  Index dimToShrink = 0;
-  while (sizeInBytes > (1L << 32L)) {
-    if (chunk_dims[dimToShrink] > 1) {
-      chunk_dims[dimToShrink] /= 2;
-      sizeInBytes /= 2;
-    }
-    dimToShrink = (dimToShrink + 1) % ND;
-  }
 
   auto const space = H5Screate_simple(ND, ds_dims, NULL);
-  auto const plist = H5Pcreate(H5P_DATASET_CREATE);
-  status = H5Pset_deflate(plist, 2);
-  status = H5Pset_chunk(plist, ND, chunk_dims);
+  auto const plist = create_plist<Scalar, ND>(name, ds_dims, false);
 
   hid_t const tid = type<Scalar>();
   hid_t const dset = H5Dcreate(parent, name.c_str(), tid, space, H5P_DEFAULT, plist, H5P_DEFAULT);
@@ -58,6 +102,90 @@ void store_tensor(Handle const &parent, std::string const &name, Eigen::Tensor<S
   }
 }
 
+template <typename Scalar, int ND>
+void create_tensor(Handle const &parent, std::string const &name, Eigen::DSizes<Index, ND> const &dims)
+{
+  for (Index ii = 0; ii < ND; ii++) {
+    if (dims[ii] == 0) {
+      Log::Fail(FMT_STRING("Tensor {} had a zero dimension. Dims: {}"), name, dims);
+    }
+  }
+
+  hsize_t ds_dims[ND];
+  // HD5=row-major, Eigen=col-major, so need to reverse the dimensions
+  std::copy_n(dims.rbegin(), ND, ds_dims);
+
+  auto const space = H5Screate_simple(ND, ds_dims, NULL);
+  auto const plist = create_plist<Scalar, ND>(name, ds_dims, true); // Chunks must not span slabs
+  herr_t status;
+  hid_t const dset = H5Dcreate(parent, name.c_str(), type<Scalar>(), space, H5P_DEFAULT, plist, H5P_DEFAULT);
+  if (dset < 0) {
+    Log::Fail(FMT_STRING("Could not create tensor {}. Dims {}. Error {}"), name, fmt::join(dims, ","), HD5::GetError());
+  }
+  status = H5Pclose(plist);
+  status = H5Sclose(space);
+  status = H5Dclose(dset);
+  if (status) {
+    Log::Fail(FMT_STRING("Creating Tensor {}: Error {}"), name, HD5::GetError());
+  } else {
+    Log::Print<Log::Level::High>(FMT_STRING("Created tensor: {}"), name);
+  }
+}
+
+template <typename Scalar, int CD>
+void store_tensor_slab(
+  Handle const &parent, std::string const &name, Index const index, Eigen::Tensor<Scalar, CD> const &tensor)
+{
+  int const ND = CD + 1;
+  hid_t dset = H5Dopen(parent, name.c_str(), H5P_DEFAULT);
+  if (dset < 0) {
+    Log::Fail(FMT_STRING("Could not open tensor '{}'"), name);
+  }
+  hid_t ds = H5Dget_space(dset);
+  auto const rank = H5Sget_simple_extent_ndims(ds);
+  if (rank != ND) {
+    Log::Fail(FMT_STRING("Tensor {}: has rank {}, expected {}"), name, rank, ND);
+  }
+
+  std::array<hsize_t, ND> dims;
+  H5Sget_simple_extent_dims(ds, dims.data(), NULL);
+  std::reverse(dims.begin(), dims.end()); // HD5=row-major, Eigen=col-major
+  for (int ii = 0; ii < ND - 1; ii++) {   // Last dimension is SUPPOSED to be different
+    if ((Index)dims[ii] != tensor.dimension(ii)) {
+      Log::Fail(
+        FMT_STRING("Tensor {}: slab dimensions were {}, but were {} on disk"),
+        name,
+        fmt::join(tensor.dimensions(), ","),
+        fmt::join(dims, ","));
+    }
+  }
+  if (index < 0 || index >= (Index)dims[ND - 1]) {
+    Log::Fail(FMT_STRING("Tensor {}: slab {} out of range {}"), name, index, dims[ND - 1]);
+  }
+  std::reverse(dims.begin(), dims.end()); // Reverse back
+
+  std::array<hsize_t, ND> h5_start, h5_stride, h5_count, h5_block;
+  h5_start[0] = index;
+  std::fill_n(h5_start.begin() + 1, CD, 0);
+  std::fill_n(h5_stride.begin(), ND, 1);
+  std::fill_n(h5_count.begin(), ND, 1);
+  h5_block[0] = 1;
+  std::copy_n(dims.begin() + 1, CD, h5_block.begin() + 1);
+  auto status =
+    H5Sselect_hyperslab(ds, H5S_SELECT_SET, h5_start.data(), h5_stride.data(), h5_count.data(), h5_block.data());
+
+  auto const mem_ds = H5Screate_simple(CD, dims.data() + 1, NULL);
+  status = H5Dwrite(dset, type<Scalar>(), mem_ds, ds, H5P_DEFAULT, tensor.data());
+  H5Sclose(mem_ds);
+  H5Sclose(ds);
+  H5Dclose(dset);
+  if (status < 0) {
+    Log::Fail(FMT_STRING("Tensor {}: Error writing slab {}. HD5 Message: {}"), name, index, GetError());
+  } else {
+    Log::Print<Log::Level::High>(FMT_STRING("Wrote slab {} to tensor {}"), index, name);
+  }
+}
+
 template <typename Derived>
 void store_matrix(Handle const &parent, std::string const &name, Eigen::DenseBase<Derived> const &data)
 {
@@ -75,8 +203,14 @@ void store_matrix(Handle const &parent, std::string const &name, Eigen::DenseBas
   std::copy_n(ds_dims, rank, chunk_dims);
   auto const space = H5Screate_simple(rank, ds_dims, NULL);
   auto const plist = H5Pcreate(H5P_DATASET_CREATE);
-  status = H5Pset_deflate(plist, rank);
+  auto const c = GetCompression();
   status = H5Pset_chunk(plist, rank, chunk_dims);
+  if (c.shuffle) {
+    status = H5Pset_shuffle(plist);
+  }
+  if (c.level > 0) {
+    status = H5Pset_deflate(plist, c.level);
+  }
 
   hid_t const tid = type<typename Derived::Scalar>();
   hid_t const dset = H5Dcreate(parent, name.c_str(), tid, space, H5P_DEFAULT, plist, H5P_DEFAULT);
@@ -169,6 +303,24 @@ template void Writer::writeTensor<Cx, 4>(Cx4 const &, std::string const &);
 template void Writer::writeTensor<Cx, 5>(Cx5 const &, std::string const &);
 template void Writer::writeTensor<Cx, 6>(Cx6 const &, std::string const &);
 
+template <typename Scalar, int ND>
+void Writer::createTensor(std::string const &label, Eigen::DSizes<Index, ND> const &dims)
+{
+  HD5::create_tensor<Scalar, ND>(handle_, label, dims);
+}
+
+template void Writer::createTensor<Cx, 4>(std::string const &, Sz4 const &);
+template void Writer::createTensor<Cx, 5>(std::string const &, Sz5 const &);
+
+template <typename Scalar, int ND>
+void Writer::writeSlab(Eigen::Tensor<Scalar, ND> const &t, Index const index, std::string const &label)
+{
+  HD5::store_tensor_slab(handle_, label, index, t);
+}
+
+template void Writer::writeSlab<Cx, 3>(Cx3 const &, Index const, std::string const &);
+template void Writer::writeSlab<Cx, 4>(Cx4 const &, Index const, std::string const &);
+
 template <typename Derived>
 void Writer::writeMatrix(Eigen::DenseBase<Derived> const &m, std::string const &label)
 {
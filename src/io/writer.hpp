@@ -17,6 +17,10 @@ struct Writer
 
   template <typename Scalar, int ND>
   void writeTensor(Eigen::Tensor<Scalar, ND> const &t, std::string const &label);
+  template <typename Scalar, int ND>
+  void createTensor(std::string const &label, Eigen::DSizes<Index, ND> const &dims); // Chunked for writeSlab
+  template <typename Scalar, int ND>
+  void writeSlab(Eigen::Tensor<Scalar, ND> const &t, Index const index, std::string const &label);
   template <typename Derived>
   void writeMatrix(Eigen::DenseBase<Derived> const &m, std::string const &label);
 
@@ -45,7 +45,11 @@ struct Radial final : Kernel<N, Func::PadWidth>
             z1.reshape(Sz3{1, 1, PadWidth}).broadcast(Sz3{PadWidth, PadWidth, 1});
       }
     }
-    return f(z.sqrt()) * z.constant(scale);
+    if constexpr (requires { f.squared(z); }) {
+      return f.squared(z) * z.constant(scale);
+    } else {
+      return f(z.sqrt()) * z.constant(scale);
+    }
   }
 };
 
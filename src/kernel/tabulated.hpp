@@ -0,0 +1,79 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cmath>
+
+namespace rl {
+
+/*
+ * Wraps a kernel function in a look-up table to avoid evaluating exp / bessel_i0 for every sample.
+ * The tables cover z = [0, 1] at Samples points, with one point of padding below 0 and two above 1 for the cubic
+ * stencil. Order 1 is linear interpolation, order 3 is Catmull-Rom. A second table is indexed by z^2 so that radial
+ * kernels can skip the square-root.
+ */
+template <typename Func_, int Order = 1>
+struct Tabulated
+{
+  static_assert(Order == 1 || Order == 3);
+  using Func = Func_;
+  static constexpr size_t Width = Func::Width;
+  static constexpr size_t PadWidth = Func::PadWidth;
+  static constexpr Index Samples = 4096;
+
+  struct Lookup
+  {
+    float const *table; // Points at z = 0, so table[-1] is the padding
+
+    inline float operator()(float const z) const
+    {
+      if (!(z <= 1.f)) {
+        return 0.f;
+      }
+      float const x = z * (Samples - 1);
+      Index const i = x;
+      float const t = x - i;
+      if constexpr (Order == 1) {
+        return table[i] + t * (table[i + 1] - table[i]);
+      } else {
+        float const p0 = table[i - 1];
+        float const p1 = table[i];
+        float const p2 = table[i + 1];
+        float const p3 = table[i + 2];
+        return p1 + 0.5f * t * (p2 - p0 + t * (2.f * p0 - 5.f * p1 + 4.f * p2 - p3 + t * (3.f * (p1 - p2) + p3 - p0)));
+      }
+    }
+  };
+
+  Re1 table, tableSq;
+
+  Tabulated(float const osamp)
+    : table(Samples + 3)
+    , tableSq(Samples + 3)
+  {
+    Func const f(osamp);
+    Re1 z(Samples + 3);
+    for (Index ii = 0; ii < z.size(); ii++) {
+      z(ii) = (ii - 1) / float(Samples - 1);
+    }
+    table = f(z); // The kernel is even, so z = -h is valid
+    Re1 const zs = z.cwiseMax(0.f);
+    tableSq = f(zs.sqrt());
+    // There is no z^2 < 0, so extrapolate the quadratic through the first three points
+    tableSq(0) = 3.f * tableSq(1) - 3.f * tableSq(2) + tableSq(3);
+  }
+
+  template <typename T>
+  inline auto operator()(T const &z) const
+  {
+    return z.unaryExpr(Lookup{table.data() + 1});
+  }
+
+  template <typename T>
+  inline auto squared(T const &z2) const
+  {
+    return z2.unaryExpr(Lookup{tableSq.data() + 1});
+  }
+};
+
+} // namespace rl
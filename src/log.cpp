@@ -6,6 +6,7 @@
 
 #include <mutex>
 #include <stdio.h>
+#include <thread>
 #include <unistd.h>
 
 namespace rl {
@@ -23,6 +24,7 @@ bool isTTY = false;
 Index progressTarget = -1, progressCurrent = 0, progressNext = 0;
 std::mutex progressMutex;
 std::string progressMessage;
+std::thread::id const mainThread = std::this_thread::get_id(); // Statics are initialised on the main thread
 } // namespace
 
 Level CurrentLevel()
@@ -59,8 +61,13 @@ auto TheTime() -> std::string
   return fmt::format(FMT_STRING("[{:%H:%M:%S}]"), fmt::localtime(t));
 }
 
-void StartProgress(Index const amount, std::string const &text)
+auto StartProgress(Index const amount, std::string const &text) -> bool
 {
+  // Loops started by other threads, e.g. concurrent volume workers, would fight over the one progress bar
+  if (std::this_thread::get_id() != mainThread) {
+    return false;
+  }
+  std::scoped_lock lock(progressMutex);
   if (CurrentLevel() >= Level::High) {
     progressMessage = text;
     fmt::print(stderr, FMT_STRING("{} Starting {}\n"), TheTime(), progressMessage);
@@ -70,10 +77,12 @@ void StartProgress(Index const amount, std::string const &text)
     progressCurrent = 0;
     progressNext = std::floor(progressTarget / 100.f);
   }
+  return true;
 }
 
 void StopProgress()
 {
+  std::scoped_lock lock(progressMutex);
   if (isTTY && CurrentLevel() >= Level::Low) {
     progressTarget = -1;
     fmt::print(stderr, "\r");
@@ -83,11 +92,14 @@ void StopProgress()
   }
 }
 
-void Tick()
+void Tick(Index const n)
 {
-  if (isTTY && (progressTarget > 0)) {
+  if (isTTY) {
     std::scoped_lock lock(progressMutex);
-    progressCurrent++;
+    if (progressTarget <= 0) {
+      return;
+    }
+    progressCurrent += n;
     if (progressCurrent > progressNext) {
       float const percent = (100.f * progressCurrent) / progressTarget;
       fmt::print(stderr, FMT_STRING("\x1b[2K\r{:02.0f}%"), percent);
@@ -57,9 +57,10 @@ __attribute__((noreturn)) inline void Fail(fmt::format_string<Args...> const &fs
   throw Failure(msg);
 }
 
-void StartProgress(Index const counst, std::string const &label);
+// Returns false, and does nothing, unless called from the main thread. Only call StopProgress and Tick if it returned true
+auto StartProgress(Index const count, std::string const &label) -> bool;
 void StopProgress();
-void Tick();
+void Tick(Index const n = 1);
 Time Now();
 std::string ToNow(Time const t);
 
@@ -1,34 +1,58 @@
 #include "mapping.hpp"
 
+#include <atomic>
 #include <cfenv>
 #include <cmath>
+#include <future>
+#include <mutex>
 #include <range/v3/range.hpp>
 #include <range/v3/view.hpp>
 
+#include "plan-cache.hpp"
 #include "tensorOps.hpp"
+#include "threads.hpp"
 
 namespace rl {
 
+// Helper function for the grid size spanned by two corners
+template <typename Dims>
+auto extent(Dims const &minCorner, Dims const &maxCorner) -> Dims
+{
+  Dims sz;
+  std::transform(maxCorner.begin(), maxCorner.end(), minCorner.begin(), sz.begin(), std::minus());
+  return sz;
+}
+
 template <size_t Rank>
 auto Mapping<Rank>::Bucket::empty() const -> bool
 {
-  return indices.empty();
+  return start == end;
 }
 
 template <size_t Rank>
 auto Mapping<Rank>::Bucket::size() const -> Index
 {
-  return indices.size();
+  return end - start;
 }
 
 template <size_t Rank>
 auto Mapping<Rank>::Bucket::gridSize() const -> Sz<Rank>
 {
-  Sz<Rank> sz;
-  std::transform(maxCorner.begin(), maxCorner.end(), minCorner.begin(), sz.begin(), std::minus());
-  return sz;
+  return extent(minCorner, maxCorner);
 }
 
+// A bucket while it is being filled and split, before the samples are reordered
+template <size_t Rank>
+struct Bin
+{
+  Sz<Rank> minCorner{}, maxCorner{};
+  std::vector<int32_t> indices{};
+
+  auto empty() const -> bool { return indices.empty(); }
+  auto size() const -> Index { return indices.size(); }
+  auto gridSize() const -> Sz<Rank> { return extent(minCorner, maxCorner); }
+};
+
 // Helper function to convert a floating-point vector-like expression to integer values
 template <typename T>
 inline decltype(auto) nearby(T &&x)
@@ -36,6 +60,15 @@ inline decltype(auto) nearby(T &&x)
   return x.array().unaryExpr([](float const &e) { return std::nearbyint(e); });
 }
 
+// Helper function for the number of blocks to split [0, n) into, a few per thread so uneven blocks balance out
+Index nBlocks(Index const n) { return std::min<Index>(n, 4 * Threads::GlobalThreadCount()); }
+
+// Helper function to run f(block, lo, hi) over contiguous blocks of [0, n) on the thread pool
+void ForBlocks(Index const n, Index const nBlk, std::function<void(Index, Index, Index)> const &f)
+{
+  Threads::Parallel([&](Index const ik) { f(ik, ik * n / nBlk, (ik + 1) * n / nBlk); }, nBlk);
+}
+
 // Helper function to get a "good" FFT size. Empirical rule of thumb - multiples of 8 work well
 template <size_t Rank>
 Sz<Rank> fft_size(Sz<Rank> const x, float const os)
@@ -53,14 +86,13 @@ Sz<Rank> fft_size(Sz<Rank> const x, float const os)
   return fsz;
 }
 
-// Helper function to sort the cartesian indices
+// Helper function to sort the cartesian indices. Blocks are sorted in parallel, then neighbouring runs are merged
+// pairwise until only one is left
 template <size_t N>
 std::vector<int32_t> sort(std::vector<std::array<int16_t, N>> const &cart)
 {
   auto const start = Log::Now();
-  std::vector<int32_t> sorted(cart.size());
-  std::iota(sorted.begin(), sorted.end(), 0);
-  std::sort(sorted.begin(), sorted.end(), [&](Index const a, Index const b) {
+  auto const less = [&](int32_t const a, int32_t const b) {
     auto const &ac = cart[a];
     auto const &bc = cart[b];
     for (int ii = N - 1; ii >= 0; ii--) {
@@ -71,11 +103,187 @@ std::vector<int32_t> sort(std::vector<std::array<int16_t, N>> const &cart)
       }
     }
     return false;
+  };
+  std::vector<int32_t> sorted(cart.size());
+  std::iota(sorted.begin(), sorted.end(), 0);
+  Index const n = sorted.size();
+  Index const nBlk = nBlocks(n);
+  ForBlocks(n, nBlk, [&](Index, Index const lo, Index const hi) {
+    std::sort(sorted.begin() + lo, sorted.begin() + hi, less);
   });
+  for (Index width = 1; width < nBlk; width *= 2) {
+    Threads::Parallel(
+      [&](Index const ip) {
+        Index const lo = 2 * ip * width * n / nBlk;
+        Index const mid = std::min(2 * ip * width + width, nBlk) * n / nBlk;
+        Index const hi = std::min(2 * ip * width + 2 * width, nBlk) * n / nBlk;
+        std::inplace_merge(sorted.begin() + lo, sorted.begin() + mid, sorted.begin() + hi, less);
+      },
+      (nBlk + 2 * width - 1) / (2 * width));
+  }
   Log::Print<Log::Level::High>(FMT_STRING("Grid co-ord sorting: {}"), Log::ToNow(start));
   return sorted;
 }
 
+// Helper function to gather a per-sample array into a new order
+template <typename T>
+auto permute(std::vector<T> const &v, std::vector<int32_t> const &order) -> std::vector<T>
+{
+  std::vector<T> p(order.size());
+  ForBlocks(order.size(), nBlocks(order.size()), [&](Index, Index const lo, Index const hi) {
+    for (Index ii = lo; ii < hi; ii++) {
+      p[ii] = v[order[ii]];
+    }
+  });
+  return p;
+}
+
+// Helper function to shrink a bucket to the extent of its samples plus the kernel half-width
+template <size_t N, typename Bucket>
+void fit(Bucket &b, std::vector<std::array<int16_t, N>> const &cart, Index const kW)
+{
+  b.minCorner.fill(std::numeric_limits<Index>::max());
+  b.maxCorner.fill(std::numeric_limits<Index>::min());
+  for (auto const si : b.indices) {
+    for (size_t ii = 0; ii < N; ii++) {
+      b.minCorner[ii] = std::min<Index>(b.minCorner[ii], cart[si][ii] - (kW / 2));
+      b.maxCorner[ii] = std::max<Index>(b.maxCorner[ii], cart[si][ii] + 1 + (kW / 2));
+    }
+  }
+}
+
+/*
+ * Helper function to split a bucket into buckets of at most splitSize samples. The bucket is bisected at the median
+ * sample along its widest axis, so the pieces stay compact and can often be gridded concurrently. Samples that all
+ * lie on one grid point cannot be separated spatially, so those are split into chunks that share the same bounds.
+ */
+template <size_t N, typename Bucket>
+void subdivide(
+  Bucket &&b, std::vector<std::array<int16_t, N>> const &cart, Index const kW, Index const splitSize, std::vector<Bucket> &out)
+{
+  fit(b, cart, kW);
+  if (b.size() <= splitSize) {
+    out.push_back(std::move(b));
+    return;
+  }
+  auto const sz = b.gridSize();
+  auto const axis = std::distance(sz.begin(), std::max_element(sz.begin(), sz.end()));
+  if (sz[axis] == 1 + 2 * (kW / 2)) {
+    for (auto const indexChunk : ranges::views::chunk(b.indices, splitSize)) {
+      out.push_back(Bucket{
+        .minCorner = b.minCorner, .maxCorner = b.maxCorner, .indices = indexChunk | ranges::to<std::vector<int32_t>>()});
+    }
+    return;
+  }
+  std::vector<int16_t> coords(b.size());
+  std::transform(b.indices.begin(), b.indices.end(), coords.begin(), [&](int32_t const si) { return cart[si][axis]; });
+  std::nth_element(coords.begin(), coords.begin() + coords.size() / 2, coords.end());
+  int16_t const median = coords[coords.size() / 2];
+  // The median can equal the lowest co-ordinate if many samples share it, in which case split just above it
+  bool const low = median == b.minCorner[axis] + (kW / 2);
+  auto const mid = std::stable_partition(b.indices.begin(), b.indices.end(), [&](int32_t const si) {
+    return low ? cart[si][axis] <= median : cart[si][axis] < median;
+  });
+  Bucket left{.indices = std::vector<int32_t>(b.indices.begin(), mid)};
+  Bucket right{.indices = std::vector<int32_t>(mid, b.indices.end())};
+  subdivide(std::move(left), cart, kW, splitSize, out);
+  subdivide(std::move(right), cart, kW, splitSize, out);
+}
+
+// Helper function to greedily color the buckets so that no two buckets with the same color overlap
+template <typename Bucket>
+std::vector<std::vector<int32_t>> color(std::vector<Bucket> const &buckets)
+{
+  auto const start = Log::Now();
+  auto overlaps = [](Bucket const &a, Bucket const &b) {
+    for (size_t ii = 0; ii < a.minCorner.size(); ii++) {
+      if (a.maxCorner[ii] <= b.minCorner[ii] || b.maxCorner[ii] <= a.minCorner[ii]) {
+        return false;
+      }
+    }
+    return true;
+  };
+  std::vector<std::vector<int32_t>> colors;
+  for (size_t ib = 0; ib < buckets.size(); ib++) {
+    auto c = std::find_if(colors.begin(), colors.end(), [&](std::vector<int32_t> const &color) {
+      return std::none_of(color.begin(), color.end(), [&](int32_t const jb) { return overlaps(buckets[ib], buckets[jb]); });
+    });
+    if (c == colors.end()) {
+      colors.push_back({(int32_t)ib});
+    } else {
+      c->push_back(ib);
+    }
+  }
+  Log::Print<Log::Level::High>(FMT_STRING("Bucket coloring: {} colors, {}"), colors.size(), Log::ToNow(start));
+  return colors;
+}
+
+// Helper to find the grid point and offset of a trajectory point. Returns false for the NaNs used to blank points
+template <size_t Rank>
+struct Locator
+{
+  std::array<float, Rank> scales;
+  Sz<Rank> center;
+
+  Locator(Sz3 const &matrix, Sz<Rank> const &cartDims)
+  {
+    for (size_t ii = 0; ii < Rank; ii++) {
+      scales[ii] = (cartDims[ii] / float(matrix[ii])) * ((matrix[ii] - 1) / 2) * 2;
+      center[ii] = cartDims[ii] / 2;
+    }
+  }
+
+  auto operator()(float const *const p, std::array<int16_t, Rank> &ijk, Eigen::Array<float, Rank, 1> &off) const -> bool
+  {
+    Eigen::Array<float, Rank, 1> xyz;
+    for (size_t ii = 0; ii < Rank; ii++) {
+      xyz[ii] = p[ii] * scales[ii] + center[ii];
+    }
+    if (!xyz.isFinite().all()) {
+      return false;
+    }
+    auto const gp = nearby(xyz);
+    off = xyz - gp.template cast<float>();
+    for (size_t ii = 0; ii < Rank; ii++) {
+      ijk[ii] = gp[ii];
+    }
+    return true;
+  }
+};
+
+// Helper functions to (de)serialize a mapping for the plan cache
+template <size_t Rank>
+auto Save(Mapping<Rank> const &m) -> PlanCache::Blob
+{
+  PlanCache::Blob b;
+  b.putVector(m.cart);
+  b.putVector(m.noncart);
+  b.putVector(m.offset);
+  b.putVector(m.buckets);
+  b.put<uint64_t>(m.colors.size());
+  for (auto const &c : m.colors) {
+    b.putVector(c);
+  }
+  b.putVector(m.sortedIndices);
+  return b;
+}
+
+template <size_t Rank>
+void Restore(PlanCache::Entry &e, Mapping<Rank> &m)
+{
+  m.cart = e.getVector<std::array<int16_t, Rank>>();
+  m.noncart = e.getVector<NoncartesianIndex>();
+  m.offset = e.getVector<Eigen::Array<float, Rank, 1>>();
+  m.buckets = e.getVector<typename Mapping<Rank>::Bucket>();
+  auto const nColors = e.get<uint64_t>();
+  e.require(nColors, sizeof(uint64_t)); // Each color stores at least its length
+  m.colors.resize(nColors);
+  for (auto &c : m.colors) {
+    c = e.getVector<int32_t>();
+  }
+  m.sortedIndices = e.getVector<int32_t>();
+}
+
 template <size_t Rank>
 Mapping<Rank>::Mapping(
   Trajectory const &traj, float const nomOS, Index const kW, Index const bucketSz, Index const splitSize, Index const read0)
@@ -88,105 +296,433 @@ Mapping<Rank>::Mapping(
 
   noncartDims = Sz2{traj.nSamples(), traj.nTraces()};
 
+  PlanCache::Key key;
+  if (PlanCache::Enabled()) {
+    key.add(fmt::format("Mapping<{}> v2", Rank)).add(info.matrix).add(traj.points());
+    key.add(nomOS).add(kW).add(bucketSz).add(splitSize).add(read0);
+    if (PlanCache::Load("mapping", key, [&](PlanCache::Entry &e) { Restore(e, *this); })) {
+      return;
+    }
+    cart.clear(); // In case a corrupt entry was partially read
+    noncart.clear();
+    offset.clear();
+    buckets.clear();
+    colors.clear();
+  }
+
   Sz<Rank> nB;
   for (size_t ii = 0; ii < Rank; ii++) {
     nB[ii] = std::ceil(cartDims[ii] / float(bucketSz));
   }
-  buckets.reserve(Product(nB));
+  std::vector<Bin<Rank>> bins;
+  bins.reserve(Product(nB));
 
   if constexpr (Rank == 3) {
     for (Index iz = 0; iz < nB[2]; iz++) {
       for (Index iy = 0; iy < nB[1]; iy++) {
         for (Index ix = 0; ix < nB[0]; ix++) {
-          buckets.push_back(Bucket{
+          bins.push_back(Bin<Rank>{
             Sz3{ix * bucketSz - (kW / 2), iy * bucketSz - (kW / 2), iz * bucketSz - (kW / 2)},
             Sz3{
               std::min((ix + 1) * bucketSz, cartDims[0]) + (kW / 2),
               std::min((iy + 1) * bucketSz, cartDims[1]) + (kW / 2),
-              std::min((iz + 1) * bucketSz, cartDims[2]) + (kW / 2)}});
+              std::min((iz + 1) * bucketSz, cartDims[2]) + (kW / 2)},
+            {}});
         }
       }
     }
   } else if constexpr (Rank == 2) {
     for (Index iy = 0; iy < nB[1]; iy++) {
       for (Index ix = 0; ix < nB[0]; ix++) {
-        buckets.push_back(Bucket{
+        bins.push_back(Bin<Rank>{
           Sz2{ix * bucketSz - (kW / 2), iy * bucketSz - (kW / 2)},
-          Sz2{std::min((ix + 1) * bucketSz, cartDims[0]) + (kW / 2), std::min((iy + 1) * bucketSz, cartDims[1]) + (kW / 2)}});
+          Sz2{std::min((ix + 1) * bucketSz, cartDims[0]) + (kW / 2), std::min((iy + 1) * bucketSz, cartDims[1]) + (kW / 2)},
+          {}});
       }
     }
   } else {
     for (Index ix = 0; ix < nB[0]; ix++) {
-      buckets.push_back(Bucket{Sz1{ix * bucketSz - (kW / 2)}, Sz1{std::min((ix + 1) * bucketSz, cartDims[0]) + (kW / 2)}});
+      bins.push_back(
+        Bin<Rank>{Sz1{ix * bucketSz - (kW / 2)}, Sz1{std::min((ix + 1) * bucketSz, cartDims[0]) + (kW / 2)}, {}});
     }
   }
 
-  std::fesetround(FE_TONEAREST);
-  Sz<Rank> center;
-  std::array<float, Rank> scales;
-  for (size_t ii = 0; ii < Rank; ii++) {
-    scales[ii] = (cartDims[ii] / float(info.matrix[ii])) * ((info.matrix[ii] - 1) / 2) * 2;
-    center[ii] = cartDims[ii] / 2;
-  }
-  int32_t index = 0;
-  Index NaNs = 0;
-  for (int32_t is = 0; is < traj.nTraces(); is++) {
-    for (int16_t ir = read0; ir < traj.nSamples(); ir++) {
-      Re1 const p = traj.point(ir, is);
-      Eigen::Array<float, Rank, 1> xyz;
-      for (size_t ii = 0; ii < Rank; ii++) {
-        xyz[ii] = p[ii] * scales[ii] + center[ii];
+  Locator<Rank> const locator(info.matrix, cartDims);
+  float const *const points = traj.points().data();
+  Index const nD = traj.nDims(), nS = traj.nSamples(), nT = traj.nTraces();
+  // Finds the grid point, offset and bin of a sample. Returns false for the NaNs used to blank trajectory points
+  auto locate = [&](
+                  int32_t const is, int16_t const ir, std::array<int16_t, Rank> &ijk, Eigen::Array<float, Rank, 1> &off, Index &ib) {
+    if (!locator(points + nD * (ir + nS * is), ijk, off)) {
+      return false;
+    }
+    ib = 0;
+    for (int ii = Rank - 1; ii >= 0; ii--) {
+      ib = ib * nB[ii] + (ijk[ii] / bucketSz);
+    }
+    return true;
+  };
+
+  /* Two passes over blocks of traces. The first counts the samples in each block and in each bin from each block. After
+   * prefix sums over those, the second pass writes every sample straight to its final place, so nothing is appended and
+   * the order is the same as a serial loop over traces and samples.
+   */
+  Index const nBins = bins.size();
+  Index const nBlk = nBlocks(nT);
+  std::vector<Index> blockStart(nBlk, 0), binSlot(nBlk * nBins, 0);
+  ForBlocks(nT, nBlk, [&](Index const ik, Index const lo, Index const hi) {
+    std::fesetround(FE_TONEAREST); // The rounding mode is per-thread
+    std::array<int16_t, Rank> ijk;
+    Eigen::Array<float, Rank, 1> off;
+    Index ib;
+    for (int32_t is = lo; is < hi; is++) {
+      for (int16_t ir = read0; ir < nS; ir++) {
+        if (locate(is, ir, ijk, off, ib)) {
+          blockStart[ik]++;
+          binSlot[ik * nBins + ib]++;
+        }
       }
-      if (xyz.array().isFinite().all()) { // Allow for NaNs in trajectory for blanking
-        auto const gp = nearby(xyz);
-        auto const off = xyz - gp.template cast<float>();
-        std::array<int16_t, Rank> ijk;
-        for (size_t ii = 0; ii < Rank; ii++) {
-          ijk[ii] = gp[ii];
+    }
+  });
+  Index total = 0;
+  for (auto &b : blockStart) {
+    total += std::exchange(b, total);
+  }
+  for (Index ib = 0; ib < nBins; ib++) {
+    Index n = 0;
+    for (Index ik = 0; ik < nBlk; ik++) {
+      n += std::exchange(binSlot[ik * nBins + ib], n);
+    }
+    bins[ib].indices.resize(n);
+  }
+  cart.resize(total);
+  offset.resize(total);
+  noncart.resize(total);
+  ForBlocks(nT, nBlk, [&](Index const ik, Index const lo, Index const hi) {
+    std::fesetround(FE_TONEAREST);
+    Index index = blockStart[ik];
+    Index *const slot = binSlot.data() + ik * nBins;
+    std::array<int16_t, Rank> ijk;
+    Eigen::Array<float, Rank, 1> off;
+    Index ib;
+    for (int32_t is = lo; is < hi; is++) {
+      for (int16_t ir = read0; ir < nS; ir++) {
+        if (locate(is, ir, ijk, off, ib)) {
+          cart[index] = ijk;
+          offset[index] = off;
+          noncart[index] = NoncartesianIndex{.trace = is, .sample = ir};
+          bins[ib].indices[slot[ib]++] = index;
+          index++;
         }
-        cart.push_back(ijk);
-        offset.push_back(off);
-        noncart.push_back(NoncartesianIndex{.trace = is, .sample = ir});
-
-        // Calculate bucket
-        Index ib = 0;
-        for (int ii = Rank - 1; ii >= 0; ii--) {
-          ib = ib * nB[ii] + (ijk[ii] / bucketSz);
+      }
+    }
+  });
+  Index const NaNs = nT * (nS - read0) - total;
+  Log::Print("Ignored {} non-finite trajectory points", NaNs);
+
+  Index const eraseCount = std::erase_if(bins, [](Bin<Rank> const &b) { return b.empty(); });
+  // Aim for buckets of similar work, but not so small that merging the bucket grids dominates
+  Index const target = std::clamp<Index>(total / std::max<Index>(bins.size(), 1), std::min<Index>(1024, splitSize), splitSize);
+  std::vector<Bin<Rank>> split;
+  for (auto &bin : bins) {
+    subdivide(std::move(bin), cart, kW, target, split);
+  }
+  Log::Print(
+    "Split {} non-empty buckets into {} with at most {} samples, removed {} empty", bins.size(), split.size(), target, eraseCount);
+  // Largest first, so the expensive buckets are scheduled before the cheap ones
+  std::stable_sort(split.begin(), split.end(), [](Bin<Rank> const &a, Bin<Rank> const &b) { return a.size() > b.size(); });
+
+  // Reorder the samples so that each bucket is a contiguous range and the gridding loops stream through memory
+  std::vector<int32_t> order;
+  order.reserve(total);
+  buckets.reserve(split.size());
+  for (auto const &bin : split) {
+    buckets.push_back(Bucket{
+      .minCorner = bin.minCorner,
+      .maxCorner = bin.maxCorner,
+      .start = (int32_t)order.size(),
+      .end = (int32_t)(order.size() + bin.size())});
+    order.insert(order.end(), bin.indices.begin(), bin.indices.end());
+  }
+  split.clear();
+  cart = permute(cart, order);
+  noncart = permute(noncart, order);
+  offset = permute(offset, order);
+
+  if (!buckets.empty()) {
+    float const mean = total / float(buckets.size());
+    Log::Print(
+      "Total points {}. Bucket sizes max {} mean {:.1f} min {}. Imbalance (max / mean) {:.2f}",
+      total,
+      buckets.front().size(),
+      mean,
+      buckets.back().size(),
+      buckets.front().size() / mean);
+  }
+  colors = color(buckets);
+  sortedIndices = sort(cart);
+  if (PlanCache::Enabled()) {
+    PlanCache::Store("mapping", key, Save(*this));
+  }
+}
+
+template <size_t Rank>
+Mapping<Rank>::Mapping(Mapping const &parent, Trajectory const &traj, Index const kW, Index const shift)
+  : osamp{parent.osamp}
+  , noncartDims{Sz2{traj.nSamples(), traj.nTraces()}}
+  , cartDims{parent.cartDims}
+  , nomDims{parent.nomDims}
+{
+  auto const start = Log::Now();
+  Index const nD = traj.nDims(), nS = traj.nSamples();
+  float const *const points = traj.points().data();
+  // The parent's samples that survive in the child, which are exactly those the child would map itself
+  auto keep = [&](int32_t const si) {
+    Index const is = parent.noncart[si].sample - shift;
+    if (is < 0 || is >= nS) {
+      return false;
+    }
+    float const *const p = points + nD * (is + nS * parent.noncart[si].trace);
+    return std::all_of(p, p + Rank, [](float const f) { return std::isfinite(f); });
+  };
+  Index const nPB = parent.buckets.size();
+  std::vector<Index> counts(nPB, 0);
+  Threads::For(
+    [&](Index const ib) {
+      auto const &b = parent.buckets[ib];
+      for (int32_t si = b.start; si < b.end; si++) {
+        counts[ib] += keep(si);
+      }
+    },
+    nPB,
+    "Derive mapping");
+  // Keep the largest-first order, the buckets shrink unevenly
+  std::vector<int32_t> order(nPB);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int32_t const a, int32_t const b) { return counts[a] > counts[b]; });
+  std::vector<int32_t> newIndex(nPB, -1);
+  Index total = 0;
+  for (auto const ib : order) {
+    if (counts[ib] > 0) {
+      newIndex[ib] = buckets.size();
+      // The corners are found from the kept samples below
+      buckets.push_back(
+        Bucket{.minCorner = {}, .maxCorner = {}, .start = (int32_t)total, .end = (int32_t)(total + counts[ib])});
+      total += counts[ib];
+    }
+  }
+  cart.resize(total);
+  noncart.resize(total);
+  offset.resize(total);
+  Threads::For(
+    [&](Index const ib) {
+      if (newIndex[ib] < 0) {
+        return;
+      }
+      auto &b = buckets[newIndex[ib]];
+      auto const &pb = parent.buckets[ib];
+      b.minCorner.fill(std::numeric_limits<Index>::max());
+      b.maxCorner.fill(std::numeric_limits<Index>::min());
+      int32_t index = b.start;
+      for (int32_t si = pb.start; si < pb.end; si++) {
+        if (keep(si)) {
+          cart[index] = parent.cart[si];
+          offset[index] = parent.offset[si];
+          noncart[index] = NoncartesianIndex{.trace = parent.noncart[si].trace, .sample = int16_t(parent.noncart[si].sample - shift)};
+          for (size_t ii = 0; ii < Rank; ii++) {
+            b.minCorner[ii] = std::min<Index>(b.minCorner[ii], cart[index][ii] - (kW / 2));
+            b.maxCorner[ii] = std::max<Index>(b.maxCorner[ii], cart[index][ii] + 1 + (kW / 2));
+          }
+          index++;
         }
-        buckets[ib].indices.push_back(index);
-        index++;
-      } else {
-        NaNs++;
       }
+    },
+    nPB,
+    "Derive mapping");
+  // The buckets only shrink, so buckets that did not overlap still do not
+  for (auto const &pc : parent.colors) {
+    std::vector<int32_t> c;
+    for (auto const ib : pc) {
+      if (newIndex[ib] >= 0) {
+        c.push_back(newIndex[ib]);
+      }
+    }
+    if (!c.empty()) {
+      colors.push_back(std::move(c));
     }
   }
-  Log::Print("Ignored {} non-finite trajectory points", NaNs);
+  sortedIndices = sort(cart);
+  Log::Print(
+    FMT_STRING("Derived {}D Mapping with {} of {} samples in {} buckets, {}"),
+    Rank,
+    total,
+    parent.cart.size(),
+    buckets.size(),
+    Log::ToNow(start));
+}
 
-  std::vector<Bucket> chunked;
-  for (auto &bucket : buckets) {
-    if (bucket.size() > splitSize) {
-      for (auto const indexChunk : ranges::views::chunk(bucket.indices, splitSize)) {
-        chunked.push_back(Bucket{
-          .minCorner = bucket.minCorner,
-          .maxCorner = bucket.maxCorner,
-          .indices = indexChunk | ranges::to<std::vector<int32_t>>()});
+namespace {
+// Helper function for the number of leading samples removed if t is a downsampled copy of the parent's trajectory, or -1
+// if it is not. Every finite point of t must land on the same grid point with the same offset as the parent's sample,
+// which is all the mapping depends on.
+template <size_t Rank>
+auto DerivedShift(Mapping<Rank> const &parent, Trajectory const &t) -> Index
+{
+  Index const nD = t.nDims(), nS = t.nSamples(), nT = t.nTraces(), pS = parent.noncartDims[0];
+  if (nT != parent.noncartDims[1] || nS > pS) {
+    return -1;
+  }
+  Locator<Rank> const locator(t.info().matrix, parent.cartDims);
+  float const *const points = t.points().data();
+  std::fesetround(FE_TONEAREST);
+  std::array<int16_t, Rank> ijk0;
+  Eigen::Array<float, Rank, 1> off0;
+  Index first = 0;
+  while (first < nS * nT && !locator(points + nD * first, ijk0, off0)) {
+    first++;
+  }
+  if (first == nS * nT) {
+    return -1;
+  }
+  // The parent's samples on the first finite point's trace that match it give the candidate shifts. Finding them is a
+  // scan of the parent's samples, so most trajectories are rejected before allocating the inverse below.
+  Index const is0 = first % nS, it0 = first / nS;
+  std::vector<Index> shifts;
+  for (Index si = 0; si < Index(parent.noncart.size()); si++) {
+    auto const &nc = parent.noncart[si];
+    if (nc.trace == it0 && nc.sample >= is0 && nc.sample - is0 <= pS - nS && parent.cart[si] == ijk0 &&
+        (parent.offset[si] == off0).all()) {
+      shifts.push_back(nc.sample - is0);
+    }
+  }
+  if (shifts.empty()) {
+    return -1;
+  }
+  std::sort(shifts.begin(), shifts.end());
+  std::vector<int32_t> inverse(pS * nT, -1); // Parent sample for each (sample, trace)
+  ForBlocks(parent.noncart.size(), nBlocks(parent.noncart.size()), [&](Index, Index const lo, Index const hi) {
+    for (Index si = lo; si < hi; si++) {
+      inverse[parent.noncart[si].sample + pS * parent.noncart[si].trace] = si;
+    }
+  });
+  for (auto const sh : shifts) {
+    std::atomic<bool> match = true;
+    ForBlocks(nT, nBlocks(nT), [&](Index, Index const lo, Index const hi) {
+      std::fesetround(FE_TONEAREST);
+      std::array<int16_t, Rank> ijk;
+      Eigen::Array<float, Rank, 1> off;
+      for (Index it = lo; it < hi && match; it++) {
+        for (Index is = 0; is < nS; is++) {
+          if (!locator(points + nD * (is + nS * it), ijk, off)) {
+            continue;
+          }
+          int32_t const si = inverse[is + sh + pS * it];
+          if (si < 0 || parent.cart[si] != ijk || !(parent.offset[si] == off).all()) {
+            match = false;
+            break;
+          }
+        }
       }
-      bucket.indices.clear();
+    });
+    if (match) {
+      return sh;
     }
   }
+  return -1;
+}
+
+/* A mapping in the registry. Only a hash of the trajectory is kept, the mapping itself is checked when deriving from it.
+ * The mapping is a future so that it can be built without holding the registry lock, an empty pointer means the build
+ * failed.
+ */
+template <size_t Rank>
+struct Registered
+{
+  uint64_t hash;
+  Sz3 matrix;
+  float osamp;
+  Index kW, bucketSize, splitSize;
+  std::shared_future<std::weak_ptr<Mapping<Rank> const>> mapping;
+
+  auto sameParameters(Trajectory const &t, float const os, Index const w, Index const bs, Index const ss) const -> bool
+  {
+    return matrix == t.info().matrix && osamp == os && kW == w && bucketSize == bs && splitSize == ss;
+  }
 
-  Index const eraseCount = std::erase_if(buckets, [](Bucket const &b) { return b.empty(); });
-  buckets.insert(buckets.end(), chunked.begin(), chunked.end());
-  Log::Print("Added {} extra, removed {} empty buckets, {} remaining", chunked.size(), eraseCount, buckets.size());
+  auto ready() const -> bool { return mapping.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+  auto expired() const -> bool { return ready() && mapping.get().expired(); }
+};
+} // namespace
 
-  Log::Print("Total points {}", std::accumulate(buckets.begin(), buckets.end(), 0L, [](Index sum, Bucket const &b) {
-               return b.indices.size() + sum;
-             }));
-  sortedIndices = sort(cart);
+template <size_t Rank>
+auto SharedMapping(Trajectory const &t, float const nomOSamp, Index const kW, Index const bucketSize, Index const splitSize)
+  -> std::shared_ptr<Mapping<Rank> const>
+{
+  static std::mutex mutex;
+  static std::vector<Registered<Rank>> registry;
+  PlanCache::Key key;
+  key.add(fmt::format("Mapping<{}>", Rank)).add(t.info().matrix).add(t.points());
+  std::unique_lock lock(mutex);
+  std::erase_if(registry, [](Registered<Rank> const &r) { return r.expired(); });
+  for (auto const &r : registry) {
+    if (r.hash == key.hash && r.sameParameters(t, nomOSamp, kW, bucketSize, splitSize)) {
+      auto const mapping = r.mapping;
+      lock.unlock(); // Wait for a mapping still being built without blocking other trajectories
+      if (auto m = mapping.get().lock()) {
+        Log::Print(FMT_STRING("Sharing {}D Mapping with {} other users"), Rank, m.use_count() - 1);
+        return m;
+      }
+      lock.lock();
+      break;
+    }
+  }
+  std::vector<std::shared_ptr<Mapping<Rank> const>> parents;
+  for (auto const &r : registry) {
+    if (r.sameParameters(t, nomOSamp, kW, bucketSize, splitSize) && r.ready()) {
+      if (auto parent = r.mapping.get().lock()) {
+        parents.push_back(parent);
+      }
+    }
+  }
+  std::promise<std::weak_ptr<Mapping<Rank> const>> promise;
+  registry.push_back(Registered<Rank>{
+    .hash = key.hash,
+    .matrix = t.info().matrix,
+    .osamp = nomOSamp,
+    .kW = kW,
+    .bucketSize = bucketSize,
+    .splitSize = splitSize,
+    .mapping = promise.get_future().share()});
+  lock.unlock();
+
+  std::shared_ptr<Mapping<Rank> const> m;
+  try {
+    for (auto const &parent : parents) {
+      if (Index const sh = DerivedShift(*parent, t); sh >= 0) {
+        m = std::make_shared<Mapping<Rank> const>(*parent, t, kW, sh);
+        break;
+      }
+    }
+    if (!m) {
+      m = std::make_shared<Mapping<Rank> const>(t, nomOSamp, kW, bucketSize, splitSize);
+    }
+  } catch (...) {
+    promise.set_value({}); // Anyone waiting builds their own and sees the error themselves
+    throw;
+  }
+  promise.set_value(m);
+  return m;
 }
 
 template struct Mapping<1>;
 template struct Mapping<2>;
 template struct Mapping<3>;
 
+template auto SharedMapping<1>(Trajectory const &, float const, Index const, Index const, Index const)
+  -> std::shared_ptr<Mapping<1> const>;
+template auto SharedMapping<2>(Trajectory const &, float const, Index const, Index const, Index const)
+  -> std::shared_ptr<Mapping<2> const>;
+template auto SharedMapping<3>(Trajectory const &, float const, Index const, Index const, Index const)
+  -> std::shared_ptr<Mapping<3> const>;
+
 } // namespace rl
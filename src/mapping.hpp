@@ -4,6 +4,8 @@
 #include "trajectory.hpp"
 #include "types.hpp"
 
+#include <memory>
+
 namespace rl {
 
 struct NoncartesianIndex
@@ -15,10 +17,11 @@ struct NoncartesianIndex
 template <size_t Rank>
 struct Mapping
 {
+  // Samples are stored in bucket order, so each bucket is the contiguous range [start, end)
   struct Bucket
   {
-    Sz<Rank> minCorner, maxCorner;
-    std::vector<int32_t> indices;
+    Sz<Rank> minCorner{}, maxCorner{};
+    int32_t start = 0, end = 0;
 
     auto empty() const -> bool;
     auto size() const -> Index;
@@ -33,15 +36,30 @@ struct Mapping
     Index const splitSize = 16384,
     Index const read0 = 0);
 
+  // Derives the mapping of a trajectory whose points are the parent's, starting shift samples later and with some blanked
+  Mapping(Mapping const &parent, Trajectory const &t, Index const kW, Index const shift);
+
   float osamp;
   Sz2 noncartDims;
   Sz<Rank> cartDims, nomDims;
 
+  // Per-sample arrays, in bucket order
   std::vector<std::array<int16_t, Rank>> cart;
   std::vector<NoncartesianIndex> noncart;
   std::vector<Eigen::Array<float, Rank, 1>> offset;
   std::vector<Bucket> buckets;
+  std::vector<std::vector<int32_t>> colors; // Groups of buckets that do not overlap and can be written concurrently
   std::vector<int32_t> sortedIndices;
 };
 
+/*
+ * Returns a mapping shared with every other user in this process with the same trajectory and parameters, e.g. the SDC,
+ * preconditioner, SENSE calibration and recon gridders of one run. A trajectory that is a downsampled copy of one that
+ * is already mapped, as produced by Trajectory::downsample without shrinking, is derived from that mapping instead of
+ * being mapped from scratch. Mappings are freed with their last user.
+ */
+template <size_t Rank>
+auto SharedMapping(Trajectory const &t, float const nomOSamp, Index const kW, Index const bucketSize = 32, Index const splitSize = 16384)
+  -> std::shared_ptr<Mapping<Rank> const>;
+
 } // namespace rl
@@ -1,5 +1,5 @@
 #include "apodize.hpp"
-#include "grid.hpp"
+#include "fft/fft.hpp"
 #include "log.hpp"
 #include "tensorOps.hpp"
 #include "threads.hpp"
@@ -7,46 +7,53 @@
 namespace rl {
 
 template <size_t NDim>
-ApodizeOp<NDim>::ApodizeOp(InputDims const &dims, GridBase<Scalar, NDim> *gridder)
-  : Parent("ApodizeOp", dims, dims)
+ApodizePadOp<NDim>::ApodizePadOp(Sz<NDim> const &imgSize, GridBase<Scalar, NDim> *gridder)
+  : Parent("ApodizePadOp", Concatenate(FirstN<2>(gridder->input().dimensions()), imgSize), gridder->input())
 {
-  init(gridder);
-}
-
-template <size_t NDim>
-void ApodizeOp<NDim>::init(GridBase<Scalar, NDim> *gridder)
-{
-  for (size_t ii = 0; ii < 2; ii++) {
-    res_[ii] = 1;
-    brd_[ii] = inputDimensions()[ii];
+  auto const in = inputDimensions();
+  auto const out = outputDimensions();
+  for (size_t ii = 0; ii < NDim + 2; ii++) {
+    if (in[ii] > out[ii]) {
+      Log::Fail(FMT_STRING("Padding input dims {} larger than output dims {}"), in, out);
+    }
+    left_[ii] = (out[ii] - in[ii] + 1) / 2; // Same as PadOp and the pruned FFT
+    paddings_[ii] = std::make_pair(left_[ii], (out[ii] - in[ii]) / 2);
+    res_[ii] = ii < 2 ? 1 : in[ii];
+    brd_[ii] = ii < 2 ? in[ii] : 1;
   }
-  for (size_t ii = 2; ii < NDim + 2; ii++) {
-    res_[ii] = inputDimensions()[ii];
-    brd_[ii] = 1;
+
+  apo_ = gridder->apodization(imgSize);
+  for (size_t id = 0; id < NDim; id++) {
+    for (size_t ii = 0; ii < NDim + 2; ii++) {
+      phaseRes_[id][ii] = ii == id + 2 ? in[ii] : 1;
+      phaseBrd_[id][ii] = ii == id + 2 ? 1 : in[ii];
+    }
+    phase_[id] = FFT::Phase(out[id + 2]).slice(Sz1{left_[id + 2]}, Sz1{imgSize[id]});
   }
-  apo_ = gridder->apodization(LastN<NDim>(inputDimensions())).template cast<Cx>();
 }
 
 template <size_t NDim>
-auto ApodizeOp<NDim>::forward(InputMap x) const -> OutputMap
+auto ApodizePadOp<NDim>::forward(InputMap x) const -> OutputMap
 {
   auto const time = this->startForward(x);
-  x.device(Threads::GlobalDevice()) = x * apo_.reshape(res_).broadcast(brd_);
-  this->finishForward(x, time);
-  return x;
+  this->output().device(Threads::GlobalDevice()) = (x * apo_->template cast<Cx>().reshape(res_).broadcast(brd_) * phase<NDim - 1>()).pad(paddings_);
+  this->finishForward(this->output(), time);
+  return this->output();
 }
 
+// The phase has unit magnitude, so the adjoint is the conjugate
 template <size_t NDim>
-auto ApodizeOp<NDim>::adjoint(OutputMap x) const -> InputMap
+auto ApodizePadOp<NDim>::adjoint(OutputMap y) const -> InputMap
 {
-  auto const time = this->startAdjoint(x);
-  x.device(Threads::GlobalDevice()) = x * apo_.reshape(res_).broadcast(brd_);
-  this->finishForward(x, time);
-  return x;
+  auto const time = this->startAdjoint(y);
+  this->input().device(Threads::GlobalDevice()) =
+    y.slice(left_, inputDimensions()) * apo_->template cast<Cx>().reshape(res_).broadcast(brd_) * phase<NDim - 1>().conjugate();
+  this->finishAdjoint(this->input(), time);
+  return this->input();
 }
 
-template struct ApodizeOp<1>;
-template struct ApodizeOp<2>;
-template struct ApodizeOp<3>;
+template struct ApodizePadOp<1>;
+template struct ApodizePadOp<2>;
+template struct ApodizePadOp<3>;
 
 } // namespace rl
@@ -1,21 +1,40 @@
 #pragma once
 
-#include "operator.hpp"
+#include "operator-alloc.hpp"
 #include "gridBase.hpp"
 
 namespace rl {
 
-template<size_t NDim>
-struct ApodizeOp final : Operator<Cx, NDim + 2, NDim + 2>
+/*
+ * Apodization, zero-padding onto the grid and the image-space half of the FFT shift, in one pass over memory. The
+ * output is the gridder's input, and the FFT should be created with imagePhase = false so the shift is not applied
+ * twice. The apodization is shared with other NUFFTs on the same grid, the separable shift is applied on the fly.
+ */
+template <size_t NDim>
+struct ApodizePadOp final : OperatorAlloc<Cx, NDim + 2, NDim + 2>
 {
-  OP_INHERIT( Cx, NDim + 2, NDim + 2 )
-  ApodizeOp(InputDims const &inSize, GridBase<Scalar, NDim> *gridder);
-  OP_DECLARE()
+  OPALLOC_INHERIT(Cx, NDim + 2, NDim + 2)
+  ApodizePadOp(Sz<NDim> const &imgSize, GridBase<Scalar, NDim> *gridder);
+  OPALLOC_DECLARE()
 
 private:
-  InputDims res_, brd_;
-  Eigen::Tensor<Cx, NDim> apo_;
-  void init(GridBase<Scalar, NDim> *gridder);
+  InputDims left_, res_, brd_;
+  Eigen::array<std::pair<Index, Index>, NDim + 2> paddings_;
+  std::shared_ptr<Eigen::Tensor<float, NDim> const> apo_;
+  std::array<Cx1, NDim> phase_; // FFT shift along each image dimension
+  std::array<InputDims, NDim> phaseRes_, phaseBrd_;
+
+  // Helper function for the product of the phases along dimensions [0, D]
+  template <size_t D>
+  auto phase() const
+  {
+    auto const p = phase_[D].reshape(phaseRes_[D]).broadcast(phaseBrd_[D]);
+    if constexpr (D == 0) {
+      return p;
+    } else {
+      return phase<D - 1>() * p;
+    }
+  }
 };
 
 } // namespace rl
@@ -25,6 +25,13 @@ struct FFTOp final : Operator<Cx, Rank, Rank>
   {
   }
 
+  // Only transforms lines through the central active region, for zero-padded data that will be cropped again
+  FFTOp(InputMap x, Eigen::DSizes<Index, FFTRank> const &active, bool const imagePhase = true)
+    : Parent("FFTOp", x.dimensions(), x.dimensions())
+    , fft_{FFT::Make<Rank, FFTRank>(x, active, imagePhase)}
+  {
+  }
+
   auto forward(InputMap x) const -> OutputMap
   {
     auto const time = this->startForward(x);
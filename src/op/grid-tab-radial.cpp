@@ -0,0 +1,104 @@
+#include "grid.hpp"
+#include "kernel/expsemi.hpp"
+#include "kernel/kaiser.hpp"
+#include "kernel/radial.hpp"
+#include "kernel/tabulated.hpp"
+#include "make_grid.hpp"
+
+namespace rl {
+
+template <typename Scalar, size_t ND, typename Func>
+auto make_tab_radial_grid(
+  Trajectory const &traj, float const osamp, Index const nC, std::optional<Re2> const &basis, GridOpts const &opts)
+  -> std::shared_ptr<GridBase<Scalar, ND>>
+{
+  using K = Radial<ND, Func>;
+  return std::make_shared<Grid<Scalar, K>>(SharedMapping<ND>(traj, osamp, K::PadWidth), nC, basis, opts);
+}
+
+template <typename Scalar, size_t ND, template <size_t> typename Func, int Order>
+auto make_tab_radial_width(
+  Trajectory const &traj,
+  size_t const W,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Scalar, ND>>
+{
+  if (W == 3) {
+    return make_tab_radial_grid<Scalar, ND, Tabulated<Func<3>, Order>>(traj, osamp, nC, basis, opts);
+  } else if (W == 4) {
+    return make_tab_radial_grid<Scalar, ND, Tabulated<Func<4>, Order>>(traj, osamp, nC, basis, opts);
+  } else if (W == 5) {
+    return make_tab_radial_grid<Scalar, ND, Tabulated<Func<5>, Order>>(traj, osamp, nC, basis, opts);
+  } else if (W == 7) {
+    return make_tab_radial_grid<Scalar, ND, Tabulated<Func<7>, Order>>(traj, osamp, nC, basis, opts);
+  }
+  Log::Fail("Invalid kernel width {}", W);
+}
+
+template <typename Scalar, size_t ND>
+auto make_tab_radial(
+  Trajectory const &traj,
+  std::string const &type,
+  size_t const W,
+  int const order,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Scalar, ND>>
+{
+  if (type == "ES") {
+    if (order == 1) {
+      return make_tab_radial_width<Scalar, ND, ExpSemi, 1>(traj, W, osamp, nC, basis, opts);
+    } else if (order == 3) {
+      return make_tab_radial_width<Scalar, ND, ExpSemi, 3>(traj, W, osamp, nC, basis, opts);
+    }
+  } else if (type == "KB") {
+    if (order == 1) {
+      return make_tab_radial_width<Scalar, ND, KaiserBessel, 1>(traj, W, osamp, nC, basis, opts);
+    } else if (order == 3) {
+      return make_tab_radial_width<Scalar, ND, KaiserBessel, 3>(traj, W, osamp, nC, basis, opts);
+    }
+  }
+  Log::Fail("Invalid tabulated kernel {} order {}", type, order);
+}
+
+template auto make_tab_radial<Cx, 2>(
+  Trajectory const &traj,
+  std::string const &type,
+  size_t const W,
+  int const order,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Cx, 2>>;
+template auto make_tab_radial<Cx, 3>(
+  Trajectory const &traj,
+  std::string const &type,
+  size_t const W,
+  int const order,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Cx, 3>>;
+template auto make_tab_radial<float, 2>(
+  Trajectory const &traj,
+  std::string const &type,
+  size_t const W,
+  int const order,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<float, 2>>;
+template auto make_tab_radial<float, 3>(
+  Trajectory const &traj,
+  std::string const &type,
+  size_t const W,
+  int const order,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<float, 3>>;
+
+} // namespace rl
@@ -4,10 +4,14 @@
 #include "gridBase.hpp"
 #include "mapping.hpp"
 #include "pad.hpp"
+#include "plan-cache.hpp"
 #include "tensorOps.hpp"
 #include "threads.hpp"
 
+#include <atomic>
+#include <map>
 #include <mutex>
+#include <numeric>
 
 namespace {
 
@@ -21,33 +25,284 @@ inline Index Crop(Index const ii, Index const sz)
     return ii;
 }
 
+// Strides between consecutive grid points along each dimension, for a grid with nCB values per point
+template <int N>
+inline auto Strides(Eigen::DSizes<Index, N> const &dims, Index const nCB) -> Eigen::DSizes<Index, N>
+{
+  Eigen::DSizes<Index, N> s;
+  s[0] = nCB;
+  for (int ii = 1; ii < N; ii++) {
+    s[ii] = s[ii - 1] * dims[ii - 1];
+  }
+  return s;
+}
+
+// Calls f with the channel count as a compile-time constant for common counts so the channel loops vectorize
+template <typename F>
+inline void DispatchChannels(Index const nC, F &&f)
+{
+  switch (nC) {
+  case 1:
+    f(std::integral_constant<int, 1>());
+    break;
+  case 8:
+    f(std::integral_constant<int, 8>());
+    break;
+  case 16:
+    f(std::integral_constant<int, 16>());
+    break;
+  case 32:
+    f(std::integral_constant<int, 32>());
+    break;
+  default:
+    f(std::integral_constant<int, Eigen::Dynamic>());
+  }
+}
+
 } // namespace
 
 namespace rl {
 
+// Elements in the per-thread timepoint grids used by subspace gridding, the runs are processed in chunks to fit
+Index constexpr SubspaceChunk = 1 << 20;
+
 template <typename Scalar_, typename Kernel>
 struct Grid final : GridBase<Scalar_, Kernel::NDim>
 {
   static constexpr size_t NDim = Kernel::NDim;
   static constexpr Index kW = Kernel::PadWidth;
+  static constexpr Index kSz = NDim == 1 ? kW : (NDim == 2 ? kW * kW : kW * kW * kW);
+  using KTensor = typename Kernel::Tensor;
 
   OP_INHERIT(Scalar_, NDim + 2, 3)
 
-  Mapping<NDim> mapping;
+  std::shared_ptr<Mapping<NDim> const> sharedMapping; // See SharedMapping
+  Mapping<NDim> const &mapping;
   Kernel kernel;
   Re2 basis;
+  std::vector<float> weights;    // Cached kernel weights in sample order, empty if evaluated on-the-fly
+  std::vector<Index> bucketCost; // Number of samples in each bucket, for scheduling
+  std::vector<std::vector<Index>> colorCost;
+  bool sortedData; // See GridOpts
 
-  Grid(Mapping<NDim> const m, Index const nC, std::optional<Re2> const &b = std::nullopt)
-    : GridBase<Scalar, NDim>(AddFront(m.cartDims, nC, b ? b.value().dimension(0) : 1), AddFront(m.noncartDims, nC))
-    , mapping{m}
+  // Subspace gridding, see GridOpts. Runs of samples that share a basis timepoint, per bucket
+  struct Run
+  {
+    int32_t tp, start, end; // [start, end) indexes subOrder
+  };
+  std::vector<int32_t> subOrder;         // Sample indices, in timepoint order within each bucket
+  std::vector<std::vector<Run>> subRuns; // Empty for buckets that are gridded sample-by-sample
+
+  Grid(
+    std::shared_ptr<Mapping<NDim> const> m,
+    Index const nC,
+    std::optional<Re2> const &b = std::nullopt,
+    GridOpts const &opts = GridDefaults())
+    : GridBase<Scalar, NDim>(AddFront(m->cartDims, nC, b ? b.value().dimension(0) : 1), AddFront(m->noncartDims, nC))
+    , sharedMapping{m}
+    , mapping{*sharedMapping}
     , kernel{mapping.osamp}
     , basis{b ? *b : Re2(1, 1)}
+    , sortedData{opts.sorted}
   {
     static_assert(NDim < 4);
     if (!b) {
       basis.setConstant(1.f);
     }
     Log::Print<Log::Level::High>(FMT_STRING("Grid Dims {}"), this->inputDimensions());
+    for (auto const &bucket : mapping.buckets) {
+      bucketCost.push_back(bucket.size());
+    }
+    for (auto const &color : mapping.colors) {
+      auto &cost = colorCost.emplace_back();
+      for (auto const ib : color) {
+        cost.push_back(bucketCost[ib]);
+      }
+    }
+    cacheWeights(opts.kernelCache);
+    if (basis.dimension(0) > 1 && opts.subspace) {
+      planSubspace();
+    }
+  }
+
+  /*
+   * Sample-by-sample each sample costs kSz * nB multiply-adds per channel. With the subspace each costs kSz, plus a share
+   * of the GEMM between the timepoint grids and the basis, which costs voxels * timepoints * nB. Only buckets where that
+   * is cheaper use the subspace.
+   */
+  void planSubspace()
+  {
+    auto const start = Log::Now();
+    Index const nB = basis.dimension(0);
+    Index const nT = basis.dimension(1);
+    subOrder.resize(mapping.cart.size());
+    subRuns.resize(mapping.buckets.size());
+    std::atomic<Index> nSub = 0;
+    auto tp = [&](int32_t const si) { return int32_t(mapping.noncart[si].trace % nT); };
+    Threads::For(
+      [&](Index const ib) {
+        auto const &bucket = mapping.buckets[ib];
+        auto const first = subOrder.begin() + bucket.start;
+        auto const last = subOrder.begin() + bucket.end;
+        std::iota(first, last, bucket.start);
+        std::stable_sort(first, last, [&](int32_t const a, int32_t const b) { return tp(a) < tp(b); });
+        std::vector<Run> runs;
+        for (int32_t ii = bucket.start; ii < bucket.end;) {
+          int32_t jj = ii + 1;
+          while (jj < bucket.end && tp(subOrder[jj]) == tp(subOrder[ii])) {
+            jj++;
+          }
+          runs.push_back(Run{.tp = tp(subOrder[ii]), .start = ii, .end = jj});
+          ii = jj;
+        }
+        if (Product(bucket.gridSize()) * Index(runs.size()) * nB < bucket.size() * kSz * (nB - 1)) {
+          subRuns[ib] = std::move(runs);
+          nSub++;
+        }
+      },
+      bucketCost,
+      "Subspace plan");
+    Log::Print(
+      FMT_STRING("Subspace gridding for {} of {} buckets, planned in {}"), nSub.load(), mapping.buckets.size(), Log::ToNow(start));
+  }
+
+  auto subspace(Index const ib) const -> bool { return !subRuns.empty() && !subRuns[ib].empty(); }
+
+  // The basis entries for a chunk of runs, as the columns of a matrix
+  auto basisFor(std::vector<Run> const &runs, Index const r0, Index const nR) const
+    -> Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>
+  {
+    Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> b(basis.dimension(0), nR);
+    for (Index ir = 0; ir < nR; ir++) {
+      for (Index ib = 0; ib < basis.dimension(0); ib++) {
+        b(ib, ir) = basis(ib, runs[r0 + ir].tp);
+      }
+    }
+    return b;
+  }
+
+  // Calls f(offset, weight) for each kernel point around a sample, with offsets into a bucket grid with strides bStride
+  template <typename F>
+  static inline void ForKernel(
+    std::array<int16_t, NDim> const &c,
+    Sz<NDim> const &minCorner,
+    Sz<NDim> const &bStride,
+    Eigen::TensorMap<KTensor const> const &k,
+    F &&f)
+  {
+    Index constexpr hW = kW / 2;
+    for (Index i1 = 0; i1 < kW; i1++) {
+      Index const ii1 = i1 + c[NDim - 1] - hW - minCorner[NDim - 1];
+      if constexpr (NDim == 1) {
+        f(ii1 * bStride[0], k(i1));
+      } else {
+        for (Index i2 = 0; i2 < kW; i2++) {
+          Index const ii2 = i2 + c[NDim - 2] - hW - minCorner[NDim - 2];
+          if constexpr (NDim == 2) {
+            f(ii2 * bStride[0] + ii1 * bStride[1], k(i2, i1));
+          } else {
+            for (Index i3 = 0; i3 < kW; i3++) {
+              Index const ii3 = i3 + c[NDim - 3] - hW - minCorner[NDim - 3];
+              f(ii3 * bStride[0] + ii2 * bStride[1] + ii1 * bStride[2], k(i3, i2, i1));
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Calls f(offset, bOffset) for each point of a bucket grid that lies inside the cartesian grid
+  template <typename F>
+  inline void
+  ForBucket(typename Mapping<NDim>::Bucket const &bucket, Sz<NDim> const &stride, Sz<NDim> const &bStride, F &&f) const
+  {
+    auto const &cdims = mapping.cartDims;
+    auto const bSz = bucket.gridSize();
+    for (Index i1 = 0; i1 < bSz[NDim - 1]; i1++) {
+      if (Index const ii1 = Crop(bucket.minCorner[NDim - 1] + i1, cdims[NDim - 1]); ii1 > -1) {
+        if constexpr (NDim == 1) {
+          f(ii1 * stride[0], i1 * bStride[0]);
+        } else {
+          for (Index i2 = 0; i2 < bSz[NDim - 2]; i2++) {
+            if (Index const ii2 = Crop(bucket.minCorner[NDim - 2] + i2, cdims[NDim - 2]); ii2 > -1) {
+              if constexpr (NDim == 2) {
+                f(ii2 * stride[0] + ii1 * stride[1], i2 * bStride[0] + i1 * bStride[1]);
+              } else {
+                for (Index i3 = 0; i3 < bSz[NDim - 3]; i3++) {
+                  if (Index const ii3 = Crop(bucket.minCorner[NDim - 3] + i3, cdims[NDim - 3]); ii3 > -1) {
+                    f(ii3 * stride[0] + ii2 * stride[1] + ii1 * stride[2], i3 * bStride[0] + i2 * bStride[1] + i1 * bStride[2]);
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  void cacheWeights(Index const mb)
+  {
+    Index const budget = mb * 1024 * 1024;
+    if (budget <= 0) {
+      return;
+    }
+    Index const nS = mapping.cart.size();
+    Index const bytes = nS * kSz * sizeof(float);
+    if (bytes > budget) {
+      Log::Print(FMT_STRING("Kernel cache requires {:L} bytes, budget {:L}. Evaluating on-the-fly"), bytes, budget);
+      return;
+    }
+    auto const start = Log::Now();
+    weights.resize(nS * kSz);
+    Threads::For(
+      [&](Index const ib) {
+        auto const &bucket = mapping.buckets[ib];
+        for (Index si = bucket.start; si < bucket.end; si++) {
+          KTensor const k = kernel(mapping.offset[si]);
+          std::copy_n(k.data(), kSz, weights.data() + si * kSz);
+        }
+      },
+      bucketCost,
+      "Kernel cache");
+    Log::Print(FMT_STRING("Cached {:L} bytes of kernel weights in {}"), bytes, Log::ToNow(start));
+  }
+
+  // Returns the kernel weights for a sample, from the cache if available, otherwise evaluated into temp
+  inline auto weightsFor(Index const si, KTensor &temp) const -> Eigen::TensorMap<KTensor const>
+  {
+    if (weights.empty()) {
+      temp = this->kernel(mapping.offset[si]);
+      return Eigen::TensorMap<KTensor const>(temp.data(), temp.dimensions());
+    } else {
+      return Eigen::TensorMap<KTensor const>(weights.data() + si * kSz, temp.dimensions());
+    }
+  }
+
+  // Copies the non-cartesian data between sample order and the mapping's bucket order
+  void gather(OutputMap const y, Eigen::Tensor<Scalar, 2> &sorted) const
+  {
+    Index const nC = y.dimension(0);
+    sorted.resize(nC, mapping.noncart.size());
+    Threads::For(
+      [&](Index const si) {
+        auto const n = mapping.noncart[si];
+        std::copy_n(&y(0, n.sample, n.trace), nC, &sorted(0, si));
+      },
+      sorted.dimension(1),
+      "Gather");
+  }
+
+  void scatter(Eigen::Tensor<Scalar, 2> const &sorted, OutputMap y) const
+  {
+    Index const nC = y.dimension(0);
+    Threads::For(
+      [&](Index const si) {
+        auto const n = mapping.noncart[si];
+        std::copy_n(&sorted(0, si), nC, &y(0, n.sample, n.trace));
+      },
+      sorted.dimension(1),
+      "Scatter");
   }
 
   auto forward(InputMap x) const -> OutputMap
@@ -58,51 +313,51 @@ struct Grid final : GridBase<Scalar_, Kernel::NDim>
     Index const nB = this->inputDimensions()[1];
     auto const &map = this->mapping;
     auto const &cdims = map.cartDims;
+    Sz<NDim> const stride = Strides(cdims, nC * nB);
+    Eigen::Tensor<Scalar, 2> sorted;
+    if (sortedData) {
+      sorted.resize(nC, map.noncart.size());
+    }
 
-    auto grid_task = [&](Index const ibucket) {
+    auto grid_task = [&](Index const ibucket, auto const NC) {
+      using CVec = Eigen::Matrix<Scalar, decltype(NC)::value, 1>;
       auto const &bucket = map.buckets[ibucket];
-      Eigen::Tensor<Scalar, 1> sum(nC);
+      if (subspace(ibucket)) {
+        subspaceForward(bucket, subRuns[ibucket], x, stride, NC, [&](Index const si, CVec const &s) {
+          auto const n = map.noncart[si];
+          Eigen::Map<CVec>(sorted.size() ? &sorted(0, si) : &this->output()(0, n.sample, n.trace), nC) = s;
+        });
+        return;
+      }
+      CVec sum = CVec::Zero(nC);
       Re1 bEntry(nB);
-      for (auto ii = 0; ii < bucket.size(); ii++) {
-        auto const si = bucket.indices[ii];
+      KTensor kTemp;
+      for (Index si = bucket.start; si < bucket.end; si++) {
         auto const c = map.cart[si];
         auto const n = map.noncart[si];
-        auto const k = this->kernel(map.offset[si]);
+        auto const k = weightsFor(si, kTemp);
         Index const kW_2 = ((kW - 1) / 2);
         Index const btp = n.trace % basis.dimension(1);
         bEntry = basis.chip<1>(btp);
         sum.setZero();
+        auto accumulate = [&](Index const offset, float const kval) {
+          for (Index ib = 0; ib < nB; ib++) {
+            sum += Eigen::Map<CVec const>(x.data() + offset + ib * nC, nC) * (kval * bEntry(ib));
+          }
+        };
         for (Index i1 = 0; i1 < kW; i1++) {
           if (Index const ii1 = Crop(c[NDim - 1] - kW_2 + i1, cdims[NDim - 1]); ii1 > -1) {
             if constexpr (NDim == 1) {
-              float const kval = k(i1);
-              for (Index ib = 0; ib < nB; ib++) {
-                float const bval = kval * bEntry(ib);
-                for (Index ic = 0; ic < nC; ic++) {
-                  this->output()(ic, n.sample, n.trace) += x(ic, ib, ii1) * bval;
-                }
-              }
+              accumulate(ii1 * stride[0], k(i1));
             } else {
               for (Index i2 = 0; i2 < kW; i2++) {
                 if (Index const ii2 = Crop(c[NDim - 2] - kW_2 + i2, cdims[NDim - 2]); ii2 > -1) {
                   if constexpr (NDim == 2) {
-                    float const kval = k(i2, i1);
-                    for (Index ib = 0; ib < nB; ib++) {
-                      float const bval = kval * bEntry(ib);
-                      for (Index ic = 0; ic < nC; ic++) {
-                        this->output()(ic, n.sample, n.trace) += x(ic, ib, ii2, ii1) * bval;
-                      }
-                    }
+                    accumulate(ii2 * stride[0] + ii1 * stride[1], k(i2, i1));
                   } else {
                     for (Index i3 = 0; i3 < kW; i3++) {
                       if (Index const ii3 = Crop(c[NDim - 3] - kW_2 + i3, cdims[NDim - 3]); ii3 > -1) {
-                        float const kval = k(i3, i2, i1);
-                        for (Index ib = 0; ib < nB; ib++) {
-                          float const bval = kval * bEntry(ib);
-                          for (Index ic = 0; ic < nC; ic++) {
-                            this->output()(ic, n.sample, n.trace) += x(ic, ib, ii3, ii2, ii1) * bval;
-                          }
-                        }
+                        accumulate(ii3 * stride[0] + ii2 * stride[1] + ii1 * stride[2], k(i3, i2, i1));
                       }
                     }
                   }
@@ -111,10 +366,16 @@ struct Grid final : GridBase<Scalar_, Kernel::NDim>
             }
           }
         }
+        Eigen::Map<CVec>(sorted.size() ? &sorted(0, si) : &this->output()(0, n.sample, n.trace), nC) = sum;
       }
     };
 
-    Threads::For(grid_task, map.buckets.size(), "Grid Forward");
+    DispatchChannels(nC, [&](auto const NC) {
+      Threads::For([&](Index const ib) { grid_task(ib, NC); }, bucketCost, "Grid Forward");
+    });
+    if (sorted.size()) {
+      scatter(sorted, this->output());
+    }
     this->finishForward(this->output(), time);
     return this->output();
   }
@@ -125,110 +386,182 @@ struct Grid final : GridBase<Scalar_, Kernel::NDim>
     auto const &map = this->mapping;
     Index const nC = this->inputDimensions()[0];
     Index const nB = this->inputDimensions()[1];
-    auto const &cdims = map.cartDims;
+    Index const nCB = nC * nB;
+    Sz<NDim> const stride = Strides(map.cartDims, nCB);
+    Eigen::Tensor<Scalar, 2> sorted;
+    if (sortedData) {
+      gather(y, sorted);
+    }
 
-    std::mutex writeMutex;
-    auto grid_task = [&](Index ibucket) {
+    auto grid_task = [&](Index const ibucket, auto const NC) {
+      using CVec = Eigen::Matrix<Scalar, decltype(NC)::value, 1>;
+      using CBMat = Eigen::Matrix<Scalar, decltype(NC)::value, Eigen::Dynamic>;
+      using Vec = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
       auto const &bucket = map.buckets[ibucket];
       auto const bSz = bucket.gridSize();
-      Eigen::Tensor<Scalar, 2> bSample(nC, nB);
-      Input bGrid(AddFront(bSz, nC, nB));
-      bGrid.setZero();
-      for (auto ii = 0; ii < bucket.size(); ii++) {
-        auto const si = bucket.indices[ii];
-        auto const c = map.cart[si];
+      Sz<NDim> const bStride = Strides(bSz, nCB);
+      CBMat bSample(nC, nB);
+      auto bGrid = Workspace::ThreadScratch<Input>(AddFront(bSz, nC, nB));
+      KTensor kTemp;
+      auto ySample = [&](Index const si) {
         auto const n = map.noncart[si];
-        auto const k = this->kernel(map.offset[si]);
-        Index constexpr hW = kW / 2;
-        Index const btp = n.trace % basis.dimension(1);
-        for (Index ib = 0; ib < nB; ib++) {
-          float const bval = basis(ib, btp);
-          for (Index ic = 0; ic < nC; ic++) {
-            bSample(ic, ib) = y(ic, n.sample, n.trace) * bval;
+        return Eigen::Map<CVec const>(sorted.size() ? &sorted(0, si) : &y(0, n.sample, n.trace), nC);
+      };
+      if (subspace(ibucket)) {
+        subspaceAdjoint(bucket, subRuns[ibucket], ySample, bGrid.data(), NC);
+      } else {
+        bGrid.setZero();
+        for (Index si = bucket.start; si < bucket.end; si++) {
+          auto const k = weightsFor(si, kTemp);
+          Index const btp = map.noncart[si].trace % basis.dimension(1);
+          auto const yS = ySample(si);
+          for (Index ib = 0; ib < nB; ib++) {
+            bSample.col(ib) = yS * basis(ib, btp);
           }
-        }
-
-        for (Index i1 = 0; i1 < kW; i1++) {
-          Index const ii1 = i1 + c[NDim - 1] - hW - bucket.minCorner[NDim - 1];
-          if constexpr (NDim == 1) {
-            float const kval = k(i1);
+          ForKernel(map.cart[si], bucket.minCorner, bStride, k, [&](Index const offset, float const kval) {
             for (Index ib = 0; ib < nB; ib++) {
-              for (Index ic = 0; ic < nC; ic++) {
-                bGrid(ic, ib, ii1) += bSample(ic, ib) * kval;
-              }
+              Eigen::Map<CVec>(bGrid.data() + offset + ib * nC, nC) += bSample.col(ib) * kval;
             }
-          } else {
-            for (Index i2 = 0; i2 < kW; i2++) {
-              Index const ii2 = i2 + c[NDim - 2] - hW - bucket.minCorner[NDim - 2];
-              if constexpr (NDim == 2) {
-                float const kval = k(i2, i1);
-                for (Index ib = 0; ib < nB; ib++) {
-                  for (Index ic = 0; ic < nC; ic++) {
-                    bGrid(ic, ib, ii2, ii1) += bSample(ic, ib) * kval;
-                  }
-                }
-              } else {
-                for (Index i3 = 0; i3 < kW; i3++) {
-                  Index const ii3 = i3 + c[NDim - 3] - hW - bucket.minCorner[NDim - 3];
-                  float const kval = k(i3, i2, i1);
-                  for (Index ib = 0; ib < nB; ib++) {
-                    for (Index ic = 0; ic < nC; ic++) {
-                      bGrid(ic, ib, ii3, ii2, ii1) += bSample(ic, ib) * kval;
-                    }
-                  }
-                }
-              }
-            }
-          }
+          });
         }
       }
 
-      {
-        std::scoped_lock lock(writeMutex);
-        for (Index i1 = 0; i1 < bSz[NDim - 1]; i1++) {
-          if (Index const ii1 = Crop(bucket.minCorner[NDim - 1] + i1, cdims[NDim - 1]); ii1 > -1) {
-            if constexpr (NDim == 1) {
-              for (Index ib = 0; ib < nB; ib++) {
-                for (Index ic = 0; ic < nC; ic++) {
-                  this->input()(ic, ib, ii1) += bGrid(ic, ib, i1);
-                }
-              }
-            } else {
-              for (Index i2 = 0; i2 < bSz[NDim - 2]; i2++) {
-                if (Index const ii2 = Crop(bucket.minCorner[NDim - 2] + i2, cdims[NDim - 2]); ii2 > -1) {
-                  if constexpr (NDim == 2) {
-                    for (Index ib = 0; ib < nB; ib++) {
-                      for (Index ic = 0; ic < nC; ic++) {
-                        this->input()(ic, ib, ii2, ii1) += bGrid(ic, ib, i2, i1);
-                      }
-                    }
-                  } else {
-                    for (Index i3 = 0; i3 < bSz[NDim - 3]; i3++) {
-                      if (Index const ii3 = Crop(bucket.minCorner[NDim - 3] + i3, cdims[NDim - 3]); ii3 > -1) {
-                        for (Index ib = 0; ib < nB; ib++) {
-                          for (Index ic = 0; ic < nC; ic++) {
-                            this->input()(ic, ib, ii3, ii2, ii1) += bGrid(ic, ib, i3, i2, i1);
-                          }
-                        }
-                      }
-                    }
-                  }
-                }
-              }
-            }
-          }
-        }
-      }
+      // Buckets within a color do not overlap, so no locking is required for the write
+      ForBucket(bucket, stride, bStride, [&](Index const offset, Index const bOffset) {
+        Eigen::Map<Vec>(this->input().data() + offset, nCB) += Eigen::Map<Vec const>(bGrid.data() + bOffset, nCB);
+      });
     };
 
     this->input().device(Threads::GlobalDevice()) = this->input().constant(0.f);
-    Threads::For(grid_task, map.buckets.size(), "Grid Adjoint");
+    DispatchChannels(nC, [&](auto const NC) {
+      for (size_t ic = 0; ic < map.colors.size(); ic++) {
+        auto const &color = map.colors[ic];
+        Threads::For([&](Index const ii) { grid_task(color[ii], NC); }, colorCost[ic], "Grid Adjoint");
+      }
+    });
     this->finishAdjoint(this->input(), time);
     return this->input();
   }
 
-  auto apodization(Sz<NDim> const sz) const -> Eigen::Tensor<float, NDim>
+  /*
+   * Subspace forward. The bucket's part of the grid is projected onto the timepoints of a chunk of runs with one GEMM,
+   * then each sample only interpolates the channels of its own timepoint.
+   */
+  template <typename NC, typename Store>
+  void subspaceForward(
+    typename Mapping<NDim>::Bucket const &bucket,
+    std::vector<Run> const &runs,
+    InputMap const &x,
+    Sz<NDim> const &stride,
+    NC const,
+    Store &&store) const
   {
+    using CVec = Eigen::Matrix<Scalar, NC::value, 1>;
+    using Mat = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    Index const nC = this->inputDimensions()[0];
+    Index const nB = this->inputDimensions()[1];
+    auto const bSz = bucket.gridSize();
+    Index const nCV = nC * Product(bSz);
+    Index const nChunk = std::clamp<Index>(SubspaceChunk / nCV, 1, runs.size());
+    // The bucket grid is stored channels, voxels, basis so that each basis vector is a column
+    auto proj = Workspace::ThreadScratch<Eigen::Tensor<Scalar, 2>>(Sz2{nCV, nB});
+    auto tGrid = Workspace::ThreadScratch<Eigen::Tensor<Scalar, 1>>(Sz1{nCV * nChunk});
+    proj.setZero();
+    ForBucket(bucket, stride, Strides(bSz, 1), [&](Index const offset, Index const iv) {
+      for (Index ib = 0; ib < nB; ib++) {
+        Eigen::Map<CVec>(proj.data() + ib * nCV + iv * nC, nC) = Eigen::Map<CVec const>(x.data() + offset + ib * nC, nC);
+      }
+    });
+    Sz<NDim> const tStride = Strides(bSz, nC);
+    CVec sum = CVec::Zero(nC);
+    KTensor kTemp;
+    for (Index r0 = 0; r0 < Index(runs.size()); r0 += nChunk) {
+      Index const nR = std::min<Index>(nChunk, runs.size() - r0);
+      Eigen::Map<Mat> T(tGrid.data(), nCV, nR);
+      T.noalias() = Eigen::Map<Mat const>(proj.data(), nCV, nB) * basisFor(runs, r0, nR);
+      for (Index ir = 0; ir < nR; ir++) {
+        Scalar const *const tp = tGrid.data() + ir * nCV;
+        for (Index ii = runs[r0 + ir].start; ii < runs[r0 + ir].end; ii++) {
+          Index const si = subOrder[ii];
+          sum.setZero();
+          ForKernel(mapping.cart[si], bucket.minCorner, tStride, weightsFor(si, kTemp), [&](Index const o, float const kval) {
+            sum += Eigen::Map<CVec const>(tp + o, nC) * kval;
+          });
+          store(si, sum);
+        }
+      }
+    }
+  }
+
+  /*
+   * Subspace adjoint. The samples of each run in a chunk are spread onto a grid for their timepoint, channels only, and
+   * one GEMM with the basis accumulates the chunk into the basis grid. The result is reordered into bGrid.
+   */
+  template <typename NC, typename YSample>
+  void subspaceAdjoint(
+    typename Mapping<NDim>::Bucket const &bucket, std::vector<Run> const &runs, YSample &&ySample, Scalar *bGrid, NC const) const
+  {
+    using CVec = Eigen::Matrix<Scalar, NC::value, 1>;
+    using Mat = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    Index const nC = this->inputDimensions()[0];
+    Index const nB = this->inputDimensions()[1];
+    auto const bSz = bucket.gridSize();
+    Index const nV = Product(bSz);
+    Index const nCV = nC * nV;
+    Index const nChunk = std::clamp<Index>(SubspaceChunk / nCV, 1, runs.size());
+    auto proj = Workspace::ThreadScratch<Eigen::Tensor<Scalar, 2>>(Sz2{nCV, nB});
+    auto tGrid = Workspace::ThreadScratch<Eigen::Tensor<Scalar, 1>>(Sz1{nCV * nChunk});
+    Eigen::Map<Mat> P(proj.data(), nCV, nB);
+    P.setZero();
+    Sz<NDim> const tStride = Strides(bSz, nC);
+    KTensor kTemp;
+    for (Index r0 = 0; r0 < Index(runs.size()); r0 += nChunk) {
+      Index const nR = std::min<Index>(nChunk, runs.size() - r0);
+      Eigen::Map<Mat> T(tGrid.data(), nCV, nR);
+      T.setZero();
+      for (Index ir = 0; ir < nR; ir++) {
+        Scalar *const tp = tGrid.data() + ir * nCV;
+        for (Index ii = runs[r0 + ir].start; ii < runs[r0 + ir].end; ii++) {
+          Index const si = subOrder[ii];
+          auto const yS = ySample(si);
+          ForKernel(mapping.cart[si], bucket.minCorner, tStride, weightsFor(si, kTemp), [&](Index const o, float const kval) {
+            Eigen::Map<CVec>(tp + o, nC) += yS * kval;
+          });
+        }
+      }
+      P.noalias() += T * basisFor(runs, r0, nR).transpose();
+    }
+    for (Index iv = 0; iv < nV; iv++) {
+      for (Index ib = 0; ib < nB; ib++) {
+        Eigen::Map<CVec>(bGrid + (iv * nB + ib) * nC, nC) = Eigen::Map<CVec const>(proj.data() + ib * nCV + iv * nC, nC);
+      }
+    }
+  }
+
+  auto apodization(Sz<NDim> const sz) const -> std::shared_ptr<Eigen::Tensor<float, NDim> const>
+  {
+    PlanCache::Key key;
+    key.add(std::string(typeid(Kernel).name())).add(mapping.osamp).add(mapping.cartDims).add(mapping.nomDims).add(sz);
+    // Every NUFFT with the same kernel, grid and matrix needs the same apodization, so share it while any of them exist
+    static std::mutex mutex;
+    static std::map<uint64_t, std::weak_ptr<Eigen::Tensor<float, NDim> const>> shared;
+    std::scoped_lock lock(mutex);
+    std::erase_if(shared, [](auto const &s) { return s.second.expired(); });
+    if (auto const s = shared.find(key.hash); s != shared.end()) {
+      if (auto a = s->second.lock(); a && a->dimensions() == sz) {
+        Log::Print<Log::Level::High>(FMT_STRING("Sharing apodization {}"), sz);
+        return a;
+      }
+    }
+    // Helper function to share a newly loaded or calculated apodization
+    auto keep = [&](Eigen::Tensor<float, NDim> &&t) {
+      auto a = std::make_shared<Eigen::Tensor<float, NDim> const>(std::move(t));
+      shared[key.hash] = a;
+      return a;
+    };
+    if (auto a = PlanCache::LoadTensor<float, NDim>("apodization", key); a && a->dimensions() == sz) {
+      return keep(std::move(*a));
+    }
     Eigen::Tensor<Cx, NDim> temp(LastN<NDim>(this->inputDimensions()));
     auto const fft = FFT::Make<NDim, NDim>(temp);
     temp.setZero();
@@ -246,7 +579,8 @@ struct Grid final : GridBase<Scalar_, Kernel::NDim>
     Sz<NDim> center;
     std::transform(sz.begin(), sz.end(), center.begin(), [](Index i) { return i / 2; });
     LOG_DEBUG("Apodization size {} Scale: {} Norm: {} Val: {}", a.dimensions(), scale, Norm(a), a(center));
-    return a;
+    PlanCache::StoreTensor("apodization", key, a);
+    return keep(std::move(a));
   }
 };
 
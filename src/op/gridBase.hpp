@@ -8,6 +8,25 @@
 
 namespace rl {
 
+/*
+ * Options that trade memory for speed in the gridders and NUFFTs. Subspace gridding grids the samples of each basis
+ * timepoint onto their own channel-only grid and applies the basis to those grids with a GEMM, for the buckets where
+ * that is estimated to be cheaper than multiplying every kernel point by the basis.
+ */
+struct GridOpts
+{
+  Index kernelCache = 0;   // MB for caching kernel weights across operator applications, 0 disables the cache
+  bool sorted = false;     // Gather the non-cartesian data into the mapping's bucket order first, at the cost of a copy
+  bool subspace = false;   // Use subspace gridding where it is cheaper
+  Index nufftMemory = 0;   // MB for the NUFFT workspaces, channels are gridded in blocks to fit. 0 for no limit
+  Index sliceWorkers = 1;  // 2D multi-slice slices processed at once, each with its own NUFFT. 0 picks from the threads
+  bool sliceBatch = false; // Stack the 2D multi-slice slices into the channels of one NUFFT instead
+};
+
+// The options used when none are given, set from the global command-line flags
+void SetGridDefaults(GridOpts const &o);
+auto GridDefaults() -> GridOpts;
+
 // So we can template the kernel size and still stash pointers
 template <typename Scalar_, size_t NDim>
 struct GridBase : OperatorAlloc<Scalar_, NDim + 2, 3>
@@ -20,7 +39,7 @@ struct GridBase : OperatorAlloc<Scalar_, NDim + 2, 3>
   }
   virtual ~GridBase(){};
 
-  virtual auto apodization(Sz<NDim> const sz) const -> Eigen::Tensor<float, NDim> = 0;
+  virtual auto apodization(Sz<NDim> const sz) const -> std::shared_ptr<Eigen::Tensor<float, NDim> const> = 0;
 };
 
 } // namespace rl
@@ -1,27 +1,236 @@
 #pragma once
 
-#include "operator.hpp"
+#include "operator-alloc.hpp"
+#include "threads.hpp"
+
+#include <atomic>
+#include <future>
 
 namespace rl {
 
+/*
+ * Applies an operator to each of N slices, i.e. the last dimension. Given more than one instance of the operator the
+ * slices are processed concurrently, one worker per instance, each with its own buffers. The instances still use the
+ * global thread pool internally. The workers run outside the pool so that waiting on it cannot deadlock.
+ */
 template <typename Op>
 struct LoopOp final : OperatorAlloc<typename Op::Scalar, Op::InputRank + 1, Op::OutputRank + 1>
 {
   OPALLOC_INHERIT( typename Op::Scalar, Op::InputRank + 1, Op::OutputRank + 1 )
 
   LoopOp(std::shared_ptr<Op> op, Index const N)
-    : Parent("LoopOp", AddBack(op->inputDimensions(), N), AddBack(op->outputDimensions(), N))
+    : LoopOp(std::vector<std::shared_ptr<Op>>{op}, N)
+  {
+  }
+
+  LoopOp(std::vector<std::shared_ptr<Op>> const &ops, Index const N)
+    : Parent("LoopOp", AddBack(ops.front()->inputDimensions(), N), AddBack(ops.front()->outputDimensions(), N))
+    , ops_{ops}
+    , N_{N}
+  {
+  }
+
+  auto forward(InputMap x) const -> OutputMap
+  {
+    auto const time = this->startForward(x);
+    run(
+      [&](Op const &op, Index const ii) { this->output().chip(ii, OutputRank - 1) = op.forward(ChipMap(x, ii)); },
+      "Forward");
+    this->finishForward(this->output(), time);
+    return this->output();
+  }
+
+  auto adjoint(OutputMap y) const -> InputMap
+  {
+    auto const time = this->startAdjoint(y);
+    run(
+      [&](Op const &op, Index const ii) { this->input().chip(ii, InputRank - 1) = op.adjoint(ChipMap(y, ii)); },
+      "Adjoint");
+    this->finishAdjoint(this->input(), time);
+    return this->input();
+  }
+
+  auto adjfwd(InputMap x) const -> InputMap
+  {
+    run(
+      [&](Op const &op, Index const ii) { this->input().chip(ii, InputRank - 1) = op.adjfwd(ChipMap(x, ii)); },
+      "Adjoint-Forward");
+    return this->input();
+  }
+
+private:
+  std::vector<std::shared_ptr<Op>> ops_;
+  Index N_;
+
+  template <typename F>
+  void run(F const &f, std::string const &label) const
+  {
+    Index const nW = std::min<Index>(ops_.size(), N_);
+    if (nW == 1) {
+      for (Index ii = 0; ii < N_; ii++) {
+        Log::Print<Log::Level::Debug>(FMT_STRING("LoopOp {} Iteration {}"), label, ii);
+        f(*ops_.front(), ii);
+      }
+    } else {
+      std::atomic<Index> next = 0;
+      std::vector<std::future<void>> running;
+      for (Index iw = 0; iw < nW; iw++) {
+        running.push_back(std::async(std::launch::async, [&, iw]() {
+          for (Index ii = next++; ii < N_; ii = next++) {
+            Log::Print<Log::Level::Debug>(FMT_STRING("LoopOp {} Iteration {} Worker {}"), label, ii, iw);
+            f(*ops_[iw], ii);
+          }
+        }));
+      }
+      for (auto &r : running) {
+        r.get();
+      }
+    }
+  }
+};
+
+/*
+ * Applies an operator to N slices at once by stacking them in its first (channel) dimension, so that e.g. the FFTs of
+ * all the slices are a single batched call. The operator must have N times as many channels as this operator.
+ */
+template <typename Op>
+struct BatchLoopOp final : OperatorAlloc<typename Op::Scalar, Op::InputRank + 1, Op::OutputRank + 1>
+{
+  OPALLOC_INHERIT(typename Op::Scalar, Op::InputRank + 1, Op::OutputRank + 1)
+
+  BatchLoopOp(std::shared_ptr<Op> op, Index const N)
+    : Parent("BatchLoopOp", Unstack(op->inputDimensions(), N), Unstack(op->outputDimensions(), N))
+    , op_{op}
+    , N_{N}
+  {
+  }
+
+  auto forward(InputMap x) const -> OutputMap
+  {
+    auto const time = this->startForward(x);
+    auto const &dev = Threads::GlobalDevice();
+    Workspace::Lease<typename Op::Input> xs(op_->inputDimensions());
+    xs->device(dev) = x.shuffle(ToFront<InputRank>()).reshape(op_->inputDimensions());
+    auto const y = op_->forward(typename Op::InputMap(*xs));
+    this->output().device(dev) = y.reshape(Stacked(this->outputDimensions())).shuffle(ToBack<OutputRank>());
+    this->finishForward(this->output(), time);
+    return this->output();
+  }
+
+  auto adjoint(OutputMap y) const -> InputMap
+  {
+    auto const time = this->startAdjoint(y);
+    auto const &dev = Threads::GlobalDevice();
+    Workspace::Lease<typename Op::Output> ys(op_->outputDimensions());
+    ys->device(dev) = y.shuffle(ToFront<OutputRank>()).reshape(op_->outputDimensions());
+    auto const x = op_->adjoint(typename Op::OutputMap(*ys));
+    this->input().device(dev) = x.reshape(Stacked(this->inputDimensions())).shuffle(ToBack<InputRank>());
+    this->finishAdjoint(this->input(), time);
+    return this->input();
+  }
+
+  auto adjfwd(InputMap x) const -> InputMap
+  {
+    auto const &dev = Threads::GlobalDevice();
+    Workspace::Lease<typename Op::Input> xs(op_->inputDimensions());
+    xs->device(dev) = x.shuffle(ToFront<InputRank>()).reshape(op_->inputDimensions());
+    auto const y = op_->adjfwd(typename Op::InputMap(*xs));
+    this->input().device(dev) = y.reshape(Stacked(this->inputDimensions())).shuffle(ToBack<InputRank>());
+    return this->input();
+  }
+
+private:
+  std::shared_ptr<Op> op_;
+  Index N_;
+
+  // (C * N, ...) -> (C, ..., N)
+  template <typename Dims>
+  static auto Unstack(Dims const &d, Index const N)
+  {
+    if (d[0] % N) {
+      Log::Fail(FMT_STRING("BatchLoopOp first dimension {} is not a multiple of {}"), d[0], N);
+    }
+    auto u = AddBack(d, N);
+    u[0] = d[0] / N;
+    return u;
+  }
+
+  // (C, ..., N) -> (C, N, ...)
+  template <typename Dims>
+  static auto Stacked(Dims const &d)
+  {
+    Dims s;
+    s[0] = d[0];
+    s[1] = d[d.size() - 1];
+    for (size_t ii = 2; ii < d.size(); ii++) {
+      s[ii] = d[ii - 1];
+    }
+    return s;
+  }
+
+  // Shuffles between (C, ..., N) and (C, N, ...)
+  template <int R>
+  static auto ToFront()
+  {
+    Eigen::array<Index, R> p;
+    p[0] = 0;
+    p[1] = R - 1;
+    for (Index ii = 2; ii < R; ii++) {
+      p[ii] = ii - 1;
+    }
+    return p;
+  }
+
+  template <int R>
+  static auto ToBack()
+  {
+    Eigen::array<Index, R> p;
+    p[0] = 0;
+    for (Index ii = 1; ii < R - 1; ii++) {
+      p[ii] = ii + 1;
+    }
+    p[R - 1] = 1;
+    return p;
+  }
+};
+
+/*
+ * Applies an operator with a block of channels (the first dimension) to N channels, one block at a time. The last
+ * block is zero-filled if the block size does not divide N. This bounds the workspace the operator allocates.
+ */
+template <typename Op>
+struct ChannelLoopOp final : OperatorAlloc<typename Op::Scalar, Op::InputRank, Op::OutputRank>
+{
+  OPALLOC_INHERIT(typename Op::Scalar, Op::InputRank, Op::OutputRank)
+
+  ChannelLoopOp(std::shared_ptr<Op> op, Index const N)
+    : Parent(
+        "ChannelLoopOp",
+        AddFront(LastN<InputRank - 1>(op->inputDimensions()), N),
+        AddFront(LastN<OutputRank - 1>(op->outputDimensions()), N))
     , op_{op}
     , N_{N}
+    , xBlock_{op->inputDimensions()}
+    , yBlock_{op->outputDimensions()}
   {
   }
 
   auto forward(InputMap x) const -> OutputMap
   {
     auto const time = this->startForward(x);
-    for (Index ii = 0; ii < N_; ii++) {
-      Log::Print<Log::Level::Debug>(FMT_STRING("LoopOp Forward Iteration {}"), ii);
-      this->output().chip(ii, OutputRank - 1) = op_->forward(ChipMap(x, ii));
+    Index const nBlk = xBlock_.dimension(0);
+    InputDims xSt, xSz = x.dimensions();
+    OutputDims ySt, ySz = this->outputDimensions();
+    for (Index c0 = 0; c0 < N_; c0 += nBlk) {
+      Log::Print<Log::Level::Debug>(FMT_STRING("ChannelLoopOp Forward channels {}-{}"), c0, c0 + nBlk - 1);
+      xSt[0] = ySt[0] = c0;
+      xSz[0] = ySz[0] = std::min(nBlk, N_ - c0);
+      if (xSz[0] < nBlk) {
+        xBlock_.setZero();
+      }
+      xBlock_.slice(InputDims(), xSz).device(Threads::GlobalDevice()) = x.slice(xSt, xSz);
+      auto const y = op_->forward(InputMap(xBlock_));
+      this->output().slice(ySt, ySz).device(Threads::GlobalDevice()) = y.slice(OutputDims(), ySz);
     }
     this->finishForward(this->output(), time);
     return this->output();
@@ -30,9 +239,19 @@ struct LoopOp final : OperatorAlloc<typename Op::Scalar, Op::InputRank + 1, Op::
   auto adjoint(OutputMap y) const -> InputMap
   {
     auto const time = this->startAdjoint(y);
-    for (Index ii = 0; ii < N_; ii++) {
-      Log::Print<Log::Level::Debug>(FMT_STRING("LoopOp Adjoint Iteration {}"), ii);
-      this->input().chip(ii, InputRank - 1) = op_->adjoint(ChipMap(y, ii));
+    Index const nBlk = yBlock_.dimension(0);
+    InputDims xSt, xSz = this->inputDimensions();
+    OutputDims ySt, ySz = y.dimensions();
+    for (Index c0 = 0; c0 < N_; c0 += nBlk) {
+      Log::Print<Log::Level::Debug>(FMT_STRING("ChannelLoopOp Adjoint channels {}-{}"), c0, c0 + nBlk - 1);
+      xSt[0] = ySt[0] = c0;
+      xSz[0] = ySz[0] = std::min(nBlk, N_ - c0);
+      if (ySz[0] < nBlk) {
+        yBlock_.setZero();
+      }
+      yBlock_.slice(OutputDims(), ySz).device(Threads::GlobalDevice()) = y.slice(ySt, ySz);
+      auto const x = op_->adjoint(OutputMap(yBlock_));
+      this->input().slice(xSt, xSz).device(Threads::GlobalDevice()) = x.slice(InputDims(), xSz);
     }
     this->finishAdjoint(this->input(), time);
     return this->input();
@@ -40,9 +259,18 @@ struct LoopOp final : OperatorAlloc<typename Op::Scalar, Op::InputRank + 1, Op::
 
   auto adjfwd(InputMap x) const -> InputMap
   {
-    for (Index ii = 0; ii < N_; ii++) {
-      Log::Print<Log::Level::Debug>(FMT_STRING("LoopOp Adjoint-Forward Iteration {}"), ii);
-      this->input().chip(ii, InputRank - 1) = op_->adjfwd(ChipMap(x, ii));
+    Index const nBlk = xBlock_.dimension(0);
+    InputDims xSt, xSz = x.dimensions();
+    for (Index c0 = 0; c0 < N_; c0 += nBlk) {
+      Log::Print<Log::Level::Debug>(FMT_STRING("ChannelLoopOp Adjoint-Forward channels {}-{}"), c0, c0 + nBlk - 1);
+      xSt[0] = c0;
+      xSz[0] = std::min(nBlk, N_ - c0);
+      if (xSz[0] < nBlk) {
+        xBlock_.setZero();
+      }
+      xBlock_.slice(InputDims(), xSz).device(Threads::GlobalDevice()) = x.slice(xSt, xSz);
+      auto const y = op_->adjfwd(InputMap(xBlock_));
+      this->input().slice(xSt, xSz).device(Threads::GlobalDevice()) = y.slice(InputDims(), xSz);
     }
     return this->input();
   }
@@ -50,6 +278,8 @@ struct LoopOp final : OperatorAlloc<typename Op::Scalar, Op::InputRank + 1, Op::
 private:
   std::shared_ptr<Op> op_;
   Index N_;
+  Input mutable xBlock_;
+  Output mutable yBlock_;
 };
 
 }
@@ -5,58 +5,133 @@
 
 namespace rl {
 
+namespace {
+GridOpts defaults;
+}
+
+void SetGridDefaults(GridOpts const &o)
+{
+  defaults = o;
+}
+
+auto GridDefaults() -> GridOpts
+{
+  return defaults;
+}
+
 // Forward Declare
 template <typename Scalar, size_t ND>
 auto make_kb_radial(
-  Trajectory const &traj, size_t const W, float const osamp, Index const nC, std::optional<Re2> const &basis)
-  -> std::shared_ptr<GridBase<Scalar, ND>>;
+  Trajectory const &traj,
+  size_t const W,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Scalar, ND>>;
 template <typename Scalar, size_t ND>
 auto make_es_radial(
-  Trajectory const &traj, size_t const W, float const osamp, Index const nC, std::optional<Re2> const &basis)
-  -> std::shared_ptr<GridBase<Scalar, ND>>;
+  Trajectory const &traj,
+  size_t const W,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Scalar, ND>>;
 template <typename Scalar, size_t ND>
 auto make_kb_rect(
-  Trajectory const &traj, size_t const W, float const osamp, Index const nC, std::optional<Re2> const &basis)
-  -> std::shared_ptr<GridBase<Scalar, ND>>;
+  Trajectory const &traj,
+  size_t const W,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Scalar, ND>>;
 template <typename Scalar, size_t ND>
 auto make_es_rect(
-  Trajectory const &traj, size_t const W, float const osamp, Index const nC, std::optional<Re2> const &basis)
-  -> std::shared_ptr<GridBase<Scalar, ND>>;
+  Trajectory const &traj,
+  size_t const W,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Scalar, ND>>;
+template <typename Scalar, size_t ND>
+auto make_tab_radial(
+  Trajectory const &traj,
+  std::string const &type,
+  size_t const W,
+  int const order,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Scalar, ND>>;
+template <typename Scalar, size_t ND>
+auto make_tab_rect(
+  Trajectory const &traj,
+  std::string const &type,
+  size_t const W,
+  int const order,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Scalar, ND>>;
+
+// Helper function to parse the single digit of a kernel width or table order, failing cleanly on anything else
+inline auto ParseDigit(std::string const &kType, std::string const &d) -> int
+{
+  if (d.size() != 1 || !std::isdigit(static_cast<unsigned char>(d[0]))) {
+    Log::Fail("Invalid kernel type {}", kType);
+  }
+  return d[0] - '0';
+}
 
 template <typename Scalar, size_t ND>
 auto make_grid(
-  Trajectory const &traj, std::string const kType, float const osamp, Index const nC, std::optional<Re2> const &basis)
-  -> std::shared_ptr<GridBase<Scalar, ND>>
+  Trajectory const &traj,
+  std::string const kType,
+  float const osamp,
+  Index const nC,
+  std::optional<Re2> const &basis,
+  GridOpts const &opts) -> std::shared_ptr<GridBase<Scalar, ND>>
 {
-  if (kType == "NN") {
-    return std::make_shared<Grid<Scalar, NearestNeighbour<ND>>>(Mapping<ND>(traj, osamp, 1), nC, basis);
+  // Tabulated kernels are requested with a -lut (linear) or -lut3 (cubic) suffix, e.g. ES5-lut or rectKB3-lut3
+  if (auto const lut = kType.find("-lut"); lut != std::string::npos) {
+    std::string const base = kType.substr(0, lut);
+    std::string const suffix = kType.substr(lut + 4);
+    int const order = suffix.empty() ? 1 : ParseDigit(kType, suffix);
+    if (base.size() == 7 && base.substr(0, 4) == "rect") {
+      return make_tab_rect<Scalar, ND>(
+        traj, base.substr(4, 2), ParseDigit(kType, base.substr(6, 1)), order, osamp, nC, basis, opts);
+    } else if (base.size() == 3) {
+      return make_tab_radial<Scalar, ND>(
+        traj, base.substr(0, 2), ParseDigit(kType, base.substr(2, 1)), order, osamp, nC, basis, opts);
+    }
+  } else if (kType == "NN") {
+    return std::make_shared<Grid<Scalar, NearestNeighbour<ND>>>(SharedMapping<ND>(traj, osamp, 1), nC, basis, opts);
   } else if (kType.size() == 7 && kType.substr(0, 4) == "rect") {
     std::string const type = kType.substr(4, 2);
-    size_t const W = std::stoi(kType.substr(6, 1));
+    size_t const W = ParseDigit(kType, kType.substr(6, 1));
     if (type == "ES") {
-      return make_es_rect<Scalar, ND>(traj, W, osamp, nC, basis);
+      return make_es_rect<Scalar, ND>(traj, W, osamp, nC, basis, opts);
     } else if (type == "KB") {
-      return make_kb_rect<Scalar, ND>(traj, W, osamp, nC, basis);
+      return make_kb_rect<Scalar, ND>(traj, W, osamp, nC, basis, opts);
     }
   } else if (kType.size() == 3) {
     std::string const type = kType.substr(0, 2);
-    size_t const W = std::stoi(kType.substr(2, 1));
+    size_t const W = ParseDigit(kType, kType.substr(2, 1));
     if (type == "ES") {
-      return make_es_radial<Scalar, ND>(traj, W, osamp, nC, basis);
+      return make_es_radial<Scalar, ND>(traj, W, osamp, nC, basis, opts);
     } else if (type == "KB") {
-      return make_kb_radial<Scalar, ND>(traj, W, osamp, nC, basis);
+      return make_kb_radial<Scalar, ND>(traj, W, osamp, nC, basis, opts);
     }
   }
   Log::Fail("Invalid kernel type {}", kType);
 }
 
-template std::shared_ptr<GridBase<Cx, 2>>
-make_grid<Cx, 2>(Trajectory const &, std::string const, float const, Index const, std::optional<Re2> const &);
-template std::shared_ptr<GridBase<float, 2>>
-make_grid<float, 2>(Trajectory const &, std::string const, float const, Index const, std::optional<Re2> const &);
-template std::shared_ptr<GridBase<Cx, 3>>
-make_grid<Cx, 3>(Trajectory const &, std::string const, float const, Index const, std::optional<Re2> const &);
-template std::shared_ptr<GridBase<float, 3>>
-make_grid<float, 3>(Trajectory const &, std::string const, float const, Index const, std::optional<Re2> const &);
+template std::shared_ptr<GridBase<Cx, 2>> make_grid<Cx, 2>(
+  Trajectory const &, std::string const, float const, Index const, std::optional<Re2> const &, GridOpts const &);
+template std::shared_ptr<GridBase<float, 2>> make_grid<float, 2>(
+  Trajectory const &, std::string const, float const, Index const, std::optional<Re2> const &, GridOpts const &);
+template std::shared_ptr<GridBase<Cx, 3>> make_grid<Cx, 3>(
+  Trajectory const &, std::string const, float const, Index const, std::optional<Re2> const &, GridOpts const &);
+template std::shared_ptr<GridBase<float, 3>> make_grid<float, 3>(
+  Trajectory const &, std::string const, float const, Index const, std::optional<Re2> const &, GridOpts const &);
 
 } // namespace rl
@@ -15,6 +15,7 @@ std::shared_ptr<GridBase<Scalar, ND>> make_grid(
   std::string const kType,
   float const os,
   Index const nC,
-  std::optional<Re2> const &basis = std::nullopt);
+  std::optional<Re2> const &basis = std::nullopt,
+  GridOpts const &opts = GridDefaults());
 
 } // namespace rl
@@ -12,7 +12,8 @@ template <typename Op1, typename Op2>
 struct MultiplyOp final : Operator<typename Op1::Scalar, Op1::InputRank, Op2::OutputRank>
 {
   OP_INHERIT(typename Op1::Scalar, Op1::InputRank, Op2::OutputRank)
-  MultiplyOp(std::string const &name, std::shared_ptr<Op1> op1, std::shared_ptr<Op2> op2)
+  // With shareBuffers op2 uses op1's output as its input buffer, so op2 must not be applied outside this operator
+  MultiplyOp(std::string const &name, std::shared_ptr<Op1> op1, std::shared_ptr<Op2> op2, bool const shareBuffers = false)
     : Parent(name, op1->inputDimensions(), op2->outputDimensions())
     , op1_{op1}
     , op2_{op2}
@@ -21,19 +22,37 @@ struct MultiplyOp final : Operator<typename Op1::Scalar, Op1::InputRank, Op2::Ou
       Log::Fail(
         FMT_STRING("{} op1 output: {} did not match op2 input: {}"), name, op1_->outputDimensions(), op2_->inputDimensions());
     }
+    // op2's input buffer is only written by its adjoint, which op1's adjoint then reads, so they can be the same
+    if constexpr (requires { op1_->output(); }) {
+      if (shareBuffers) {
+        Index const saved = op2_->shareInput(op1_->output());
+        Log::Print<Log::Level::Debug>(FMT_STRING("{} shares buffers between operators, saving {:L} bytes"), name, saved);
+      }
+    }
   }
   using Parent::inputDimensions;
   using Parent::outputDimensions;
   auto forward(InputMap x) const -> OutputMap { return op2_->forward(op1_->forward(x)); }
   auto adjoint(OutputMap x) const -> InputMap { return op1_->adjoint(op2_->adjoint(x)); }
-  auto adjfwd(InputMap x) const -> InputMap { return op1_->adjoint(op2_->adjfwd(op1_->forward(x))); }
+  auto adjfwd(InputMap x) const -> InputMap
+  {
+    if (normal_) {
+      return normal_->forward(x);
+    } else {
+      return op1_->adjoint(op2_->adjfwd(op1_->forward(x)));
+    }
+  }
   auto input() const -> InputMap { return op1_->input(); }
+  auto shareInput(InputMap x) -> Index { return op1_->shareInput(x); }
+  // Use a dedicated operator for adjfwd, e.g. a Töplitz embedding, instead of applying both operators
+  void setNormal(std::shared_ptr<Operator<Scalar, InputRank, InputRank>> n) { normal_ = n; }
   using Parent::adjoint;
   using Parent::forward;
 
 private:
   std::shared_ptr<Op1> op1_;
   std::shared_ptr<Op2> op2_;
+  std::shared_ptr<Operator<Scalar, InputRank, InputRank>> normal_;
 };
 
 } // namespace rl
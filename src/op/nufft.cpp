@@ -7,38 +7,25 @@ namespace rl {
 
 template <size_t NDim>
 NUFFTOp<NDim>::NUFFTOp(
-  std::shared_ptr<GridBase<Cx, NDim>> gridder, Sz<NDim> const matrix, std::shared_ptr<Functor<Cx3>> sdc, bool toeplitz)
+  std::shared_ptr<GridBase<Cx, NDim>> gridder, Sz<NDim> const matrix, std::shared_ptr<Functor<Cx3>> sdc)
   : Parent(
       "NUFFTOp",
       Concatenate(FirstN<2>(gridder->inputDimensions()), AMin(matrix, LastN<NDim>(gridder->inputDimensions()))),
       gridder->outputDimensions())
   , gridder_{gridder}
-  , fft_{gridder_->input()}
-  , pad_{AMin(matrix, LastN<NDim>(gridder->inputDimensions())), gridder_->input()}
-  , apo_{pad_.inputDimensions(), gridder_.get()}
+  , fft_{gridder_->input(), AMin(matrix, LastN<NDim>(gridder->inputDimensions())), false}
+  , apoPad_{AMin(matrix, LastN<NDim>(gridder->inputDimensions())), gridder_.get()}
   , sdc_{sdc}
 {
   Log::Print<Log::Level::High>(
     "NUFFT Input Dims {} Output Dims {} Grid Dims {}", inputDimensions(), outputDimensions(), gridder_->inputDimensions());
-  if (toeplitz) {
-    Log::Print("Calculating Töplitz embedding");
-    tf_.resize(inputDimensions());
-    tf_.setConstant(1.f);
-    if (sdc_) {
-      Output temp = forward(tf_);
-      (*sdc)(temp, temp);
-      tf_ = adjoint(temp);
-    } else {
-      tf_ = adjoint(forward(tf_));
-    }
-  }
 }
 
 template <size_t NDim>
 auto NUFFTOp<NDim>::forward(InputMap x) const -> OutputMap
 {
   auto const time = this->startForward(x);
-  auto result = gridder_->forward(fft_.forward(pad_.forward(apo_.forward(x))));
+  auto result = gridder_->forward(fft_.forward(apoPad_.forward(x)));
   this->finishForward(result, time);
   return result;
 }
@@ -48,7 +35,7 @@ auto NUFFTOp<NDim>::adjoint(OutputMap y) const -> InputMap
 {
   auto const time = this->startAdjoint(y);
   (*sdc_)(ConstMap(y), y);
-  auto result = apo_.adjoint(pad_.adjoint(fft_.adjoint(gridder_->adjoint(y))));
+  auto result = apoPad_.adjoint(fft_.adjoint(gridder_->adjoint(y)));
   this->finishAdjoint(result, time);
   return result;
 }
@@ -56,13 +43,13 @@ auto NUFFTOp<NDim>::adjoint(OutputMap y) const -> InputMap
 template <size_t NDim>
 auto NUFFTOp<NDim>::adjfwd(InputMap x) const -> InputMap
 {
-  if (tf_.size() == 0) {
-    return adjoint(forward(x));
-  } else {
-    auto temp = fft_.forward(pad_.forward(x));
-    temp *= tf_;
-    return pad_.adjoint(fft_.adjoint(temp));
-  }
+  return adjoint(forward(x));
+}
+
+template <size_t NDim>
+auto NUFFTOp<NDim>::shareInput(InputMap x) -> Index
+{
+  return apoPad_.shareInput(x);
 }
 
 template <size_t NDim>
@@ -83,17 +70,63 @@ std::shared_ptr<Operator<Cx, 5, 4>> make_nufft(
   Sz3 const matrix,
   std::optional<Re2> basis,
   std::shared_ptr<Functor<Cx3>> sdc,
-  bool const toeplitz)
+  GridOpts const &opts)
 {
-  if (traj.nDims() == 2) {
-    Log::Print<Log::Level::Debug>("Creating 2D Multi-slice NUFFT");
-    auto grid = make_grid<Cx, 2>(traj, ktype, osamp * (toeplitz ? 2.f : 1.f), nC, basis);
-    auto nufft2 = std::make_shared<NUFFTOp<2>>(grid, FirstN<2>(matrix), sdc, toeplitz);
-    return std::make_shared<LoopOp<NUFFTOp<2>>>(nufft2, traj.info().matrix[2]);
+  // For 2D, either every slice is stacked into one NUFFT or a number of slices are processed concurrently
+  Index const nZ = traj.nDims() == 2 ? traj.info().matrix[2] : 1;
+  Index nWorkers = 1;
+  if (traj.nDims() == 2 && !opts.sliceBatch) {
+    // Each worker needs its own operators and workspace, so more than one is opt-in. A small 2D grid only keeps a handful
+    // of threads busy, so auto uses one worker per 8 threads
+    nWorkers = opts.sliceWorkers > 0 ? opts.sliceWorkers : Threads::GlobalThreadCount() / 8;
+    nWorkers = std::clamp<Index>(nWorkers, 1, std::min(nZ, Threads::GlobalThreadCount()));
+  }
+
+  // Estimate the per-channel workspace, i.e. the gridder's grid and samples plus the padding input
+  Index const budget = opts.nufftMemory * 1024 * 1024;
+  Index nBlk = nC;
+  if (budget > 0) {
+    Index const nB = basis ? basis.value().dimension(0) : 1;
+    Index gridVox = 1, imgVox = 1;
+    for (Index ii = 0; ii < traj.nDims(); ii++) {
+      gridVox *= std::ceil(traj.info().matrix[ii] * osamp);
+      imgVox *= matrix[ii];
+    }
+    Index const perSlice = (nB * (gridVox + imgVox) + traj.nSamples() * traj.nTraces()) * sizeof(Cx);
+    Index const perChannel = perSlice * (opts.sliceBatch ? nZ : nWorkers);
+    nBlk = std::clamp<Index>(budget / perChannel, 1, nC);
+    Index const nBlocks = (nC + nBlk - 1) / nBlk;
+    nBlk = (nC + nBlocks - 1) / nBlocks; // Even out the blocks
+    Log::Print(
+      FMT_STRING("NUFFT workspace {:L} bytes per channel, budget {:L}. Processing {} channels at a time"),
+      perChannel,
+      budget,
+      nBlk);
+  }
+
+  std::shared_ptr<Operator<Cx, 5, 4>> nufft;
+  if (traj.nDims() == 2 && opts.sliceBatch) {
+    Log::Print<Log::Level::Debug>("Creating batched 2D Multi-slice NUFFT");
+    auto grid = make_grid<Cx, 2>(traj, ktype, osamp, nBlk * nZ, basis, opts);
+    auto nufft2 = std::make_shared<NUFFTOp<2>>(grid, FirstN<2>(matrix), sdc);
+    nufft = std::make_shared<BatchLoopOp<NUFFTOp<2>>>(nufft2, nZ);
+  } else if (traj.nDims() == 2) {
+    Log::Print<Log::Level::Debug>(FMT_STRING("Creating 2D Multi-slice NUFFT with {} workers"), nWorkers);
+    std::vector<std::shared_ptr<NUFFTOp<2>>> nuffts;
+    for (Index iw = 0; iw < nWorkers; iw++) {
+      auto grid = make_grid<Cx, 2>(traj, ktype, osamp, nBlk, basis, opts);
+      nuffts.push_back(std::make_shared<NUFFTOp<2>>(grid, FirstN<2>(matrix), sdc));
+    }
+    nufft = std::make_shared<LoopOp<NUFFTOp<2>>>(nuffts, nZ);
   } else {
     Log::Print<Log::Level::Debug>("Creating full 3D NUFFT");
-    auto grid = make_grid<Cx, 3>(traj, ktype, osamp * (toeplitz ? 2.f : 1.f), nC, basis);
-    return std::make_shared<IncreaseOutputRank<NUFFTOp<3>>>(std::make_shared<NUFFTOp<3>>(grid, matrix, sdc, toeplitz));
+    auto grid = make_grid<Cx, 3>(traj, ktype, osamp, nBlk, basis, opts);
+    nufft = std::make_shared<IncreaseOutputRank<NUFFTOp<3>>>(std::make_shared<NUFFTOp<3>>(grid, matrix, sdc));
+  }
+  if (nBlk < nC) {
+    return std::make_shared<ChannelLoopOp<Operator<Cx, 5, 4>>>(nufft, nC);
+  } else {
+    return nufft;
   }
 }
 
@@ -18,22 +18,19 @@ struct NUFFTOp final : Operator<Cx, NDim + 2, 3>
   NUFFTOp(
     std::shared_ptr<GridBase<Cx, NDim>> gridder,
     Sz<NDim> const matrix,
-    std::shared_ptr<Functor<Cx3>> sdc = std::make_shared<IdentityFunctor<Cx3>>(),
-    bool toeplitz = false);
+    std::shared_ptr<Functor<Cx3>> sdc = std::make_shared<IdentityFunctor<Cx3>>());
 
   OP_DECLARE()
 
   auto adjfwd(InputMap x) const -> InputMap;
-  auto fft() const -> FFTOp<NDim + 2, NDim> const &;
+  auto shareInput(InputMap x) -> Index;
+  auto fft() const -> FFTOp<NDim + 2, NDim> const &; // Pruned, without the image-space phase
 
 private:
   std::shared_ptr<GridBase<Cx, NDim>> gridder_;
   FFTOp<NDim + 2, NDim> fft_;
-  PadOp<Cx, NDim + 2, NDim> pad_;
-  ApodizeOp<NDim> apo_;
+  ApodizePadOp<NDim> apoPad_;
   std::shared_ptr<Functor<Cx3>> sdc_;
-  using Transfer = Eigen::Tensor<Cx, NDim + 2>;
-  Transfer tf_;
 };
 
 std::shared_ptr<Operator<Cx, 5, 4>> make_nufft(
@@ -44,6 +41,6 @@ std::shared_ptr<Operator<Cx, 5, 4>> make_nufft(
   Sz3 const matrix,
   std::optional<Re2> basis = std::nullopt,
   std::shared_ptr<Functor<Cx3>> sdc = std::make_shared<IdentityFunctor<Cx3>>(),
-  bool const toeplitz = false);
+  GridOpts const &opts = GridDefaults());
 
 } // namespace rl
@@ -65,6 +65,17 @@ struct OperatorAlloc : Operator<Scalar_, InRank, OutRank>
   auto &input() const { return x_; }
   auto &output() const { return y_; }
 
+  auto shareInput(InputMap x) -> Index override
+  {
+    if (x.dimensions() != inputDimensions()) {
+      Log::Fail(FMT_STRING("{} cannot share input with dims {}, expected {}"), this->name(), x.dimensions(), inputDimensions());
+    }
+    Index const saved = xStorage_.size() * sizeof(Scalar);
+    new (&x_) InputMap(x.data(), x.dimensions()); // Re-seat the map, as per the Eigen docs for Map
+    xStorage_ = Input();
+    return saved;
+  }
+
   using Parent::adjoint;
   using Parent::forward;
   using Parent::inputDimensions;
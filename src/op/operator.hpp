@@ -3,6 +3,7 @@
 #include "../log.hpp"
 #include "tensorOps.hpp"
 #include "types.hpp"
+#include "workspace.hpp"
 
 /* Linear Operator
  *
@@ -51,17 +52,24 @@ struct Operator
   virtual auto forward(InputMap x) const -> OutputMap = 0;
   virtual auto adjoint(OutputMap y) const -> InputMap = 0;
   virtual auto adjfwd(InputMap x) const -> InputMap { Log::Fail("AdjFwd Not implemented"); }
+  // Use x, usually the previous operator's output in a chain, as the input buffer. Returns the bytes freed.
+  virtual auto shareInput(InputMap) -> Index { return 0; }
 
-  auto forward(Input const &x) const -> OutputMap
+  /* The maps may be modified in place, so work on a copy borrowed from the workspace. The result can point into that
+   * copy (e.g. for the identity or an in-place FFT), so return an owned tensor before the copy is given back.
+   */
+  auto forward(Input const &x) const -> Output
   {
-    Input xcopy = x;
-    return this->forward(InputMap(xcopy));
+    Workspace::Lease<Input> xcopy(x.dimensions());
+    *xcopy = x;
+    return Output(this->forward(InputMap(*xcopy)));
   }
 
-  auto adjoint(Output const &y) const -> InputMap
+  auto adjoint(Output const &y) const -> Input
   {
-    Output ycopy = y;
-    return this->adjoint(OutputMap(ycopy));
+    Workspace::Lease<Output> ycopy(y.dimensions());
+    *ycopy = y;
+    return Input(this->adjoint(OutputMap(*ycopy)));
   }
 
   auto startForward(InputMap x) const
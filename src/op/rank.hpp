@@ -34,6 +34,7 @@ struct IncreaseOutputRank final : Operator<typename Op::Scalar, Op::InputRank, O
   }
 
   auto adjfwd(InputMap x) const -> InputMap { return op_->adjfwd(x); }
+  auto shareInput(InputMap x) -> Index { return op_->shareInput(x); }
 
 private:
   std::shared_ptr<Op> op_;
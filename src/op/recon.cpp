@@ -4,24 +4,48 @@
 #include "nufft.hpp"
 #include "sdc.hpp"
 #include "sense.hpp"
+#include "toeplitz.hpp"
 
 namespace rl {
 
+auto make_recon_setup(
+  CoreOpts &coreOpts, SDC::Opts &sdcOpts, SENSE::Opts &senseOpts, Trajectory const &traj, HD5::Reader &reader) -> ReconSetup
+{
+  ReconSetup setup;
+  setup.basis = ReadBasis(coreOpts.basisFile.Get());
+  setup.maps = std::make_shared<Cx4 const>(SENSE::Choose(senseOpts, coreOpts, traj, reader));
+  setup.sdc = SDC::Choose(sdcOpts, traj, setup.maps->dimension(0), coreOpts.ktype.Get(), coreOpts.osamp.Get());
+  return setup;
+}
+
+auto make_recon(
+  CoreOpts &coreOpts, Trajectory const &traj, ReconSetup const &setup, bool const toeplitz, Index const toeBlock)
+  -> std::shared_ptr<ReconOp>
+{
+  auto const &basis = setup.basis;
+  auto sense = std::make_shared<SenseOp>(setup.maps, basis ? basis.value().dimension(0) : 1);
+  auto nufft = make_nufft(
+    traj, coreOpts.ktype.Get(), coreOpts.osamp.Get(), sense->nChannels(), sense->mapDimensions(), basis, setup.sdc);
+  auto recon = std::make_shared<ReconOp>("ReconOp", sense, nufft, true);
+  if (toeplitz && traj.nDims() == 2) {
+    Log::Print("Töplitz embedding is not available for 2D multi-slice, using gridding for the normal operator");
+  } else if (toeplitz) {
+    recon->setNormal(std::make_shared<ToeplitzOp>(
+      traj, coreOpts.ktype.Get(), coreOpts.osamp.Get(), setup.maps, basis, setup.sdc, toeBlock));
+  }
+  return recon;
+}
+
 auto make_recon(
   CoreOpts &coreOpts,
   SDC::Opts &sdcOpts,
   SENSE::Opts &senseOpts,
   Trajectory const &traj,
   bool const toeplitz,
-  HD5::Reader &reader) -> std::shared_ptr<ReconOp>
+  HD5::Reader &reader,
+  Index const toeBlock) -> std::shared_ptr<ReconOp>
 {
-  auto const basis = ReadBasis(coreOpts.basisFile.Get());
-  auto sense = std::make_shared<SenseOp>(
-    SENSE::Choose(senseOpts, coreOpts, traj, reader), basis ? basis.value().dimension(0) : 1);
-  auto const sdc = SDC::Choose(sdcOpts, traj, sense->nChannels(), coreOpts.ktype.Get(), coreOpts.osamp.Get());
-  auto nufft = make_nufft(
-    traj, coreOpts.ktype.Get(), coreOpts.osamp.Get(), sense->nChannels(), sense->mapDimensions(), basis, sdc, toeplitz);
-  return std::make_shared<ReconOp>("ReconOp", sense, nufft);
+  return make_recon(coreOpts, traj, make_recon_setup(coreOpts, sdcOpts, senseOpts, traj, reader), toeplitz, toeBlock);
 }
 
 } // namespace rl
\ No newline at end of file
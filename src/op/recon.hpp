@@ -12,12 +12,28 @@ namespace rl {
 
 using ReconOp = MultiplyOp<SenseOp, Operator<Cx, 5, 4>>;
 
+// The expensive parts of a recon that do not hold any operator buffers, so several ReconOps can be built from one
+struct ReconSetup
+{
+  std::optional<Re2> basis;
+  std::shared_ptr<Cx4 const> maps;
+  std::shared_ptr<Functor<Cx3>> sdc;
+};
+
+auto make_recon_setup(
+  CoreOpts &coreOpts, SDC::Opts &sdcOpts, SENSE::Opts &senseOpts, Trajectory const &traj, HD5::Reader &reader) -> ReconSetup;
+
+auto make_recon(
+  CoreOpts &coreOpts, Trajectory const &traj, ReconSetup const &setup, bool const toeplitz, Index const toeBlock = 0)
+  -> std::shared_ptr<ReconOp>;
+
 auto make_recon(
   CoreOpts &coreOpts,
   SDC::Opts &sdcOpts,
   SENSE::Opts &senseOpts,
   Trajectory const &traj,
   bool const toeplitz,
-  HD5::Reader &reader) -> std::shared_ptr<ReconOp>;
+  HD5::Reader &reader,
+  Index const toeBlock = 0) -> std::shared_ptr<ReconOp>;
 
 } // namespace rl
@@ -6,26 +6,32 @@
 namespace rl {
 
 SenseOp::SenseOp(Cx4 const &maps, Index const d0)
-  : Parent("SENSEOp", AddFront(LastN<3>(maps.dimensions()), d0), AddFront(LastN<3>(maps.dimensions()), maps.dimension(0), d0))
-  , maps_{std::move(maps)}
+  : SenseOp(std::make_shared<Cx4 const>(maps), d0)
+{
+}
+
+SenseOp::SenseOp(std::shared_ptr<Cx4 const> maps, Index const d0)
+  : Parent(
+      "SENSEOp", AddFront(LastN<3>(maps->dimensions()), d0), AddFront(LastN<3>(maps->dimensions()), maps->dimension(0), d0))
+  , maps_{maps}
 {
   resX.set(1, d0);
-  resX.set(2, maps_.dimension(1));
-  resX.set(3, maps_.dimension(2));
-  resX.set(4, maps_.dimension(3));
-  brdX.set(0, maps_.dimension(0));
-
-  resMaps.set(0, maps_.dimension(0));
-  resMaps.set(2, maps_.dimension(1));
-  resMaps.set(3, maps_.dimension(2));
-  resMaps.set(4, maps_.dimension(3));
+  resX.set(2, maps_->dimension(1));
+  resX.set(3, maps_->dimension(2));
+  resX.set(4, maps_->dimension(3));
+  brdX.set(0, maps_->dimension(0));
+
+  resMaps.set(0, maps_->dimension(0));
+  resMaps.set(2, maps_->dimension(1));
+  resMaps.set(3, maps_->dimension(2));
+  resMaps.set(4, maps_->dimension(3));
   brdMaps.set(1, d0);
 }
 
 auto SenseOp::forward(InputMap x) const -> OutputMap
 {
   auto const time = startForward(x);
-  output().device(Threads::GlobalDevice()) = x.reshape(resX).broadcast(brdX) * maps_.reshape(resMaps).broadcast(brdMaps);
+  output().device(Threads::GlobalDevice()) = x.reshape(resX).broadcast(brdX) * maps_->reshape(resMaps).broadcast(brdMaps);
   finishForward(output(), time);
   return output();
 }
@@ -33,7 +39,7 @@ auto SenseOp::forward(InputMap x) const -> OutputMap
 auto SenseOp::adjoint(OutputMap y) const -> InputMap
 {
   auto const time = startAdjoint(y);
-  input().device(Threads::GlobalDevice()) = ConjugateSum(y, maps_.reshape(resMaps).broadcast(brdMaps));
+  input().device(Threads::GlobalDevice()) = ConjugateSum(y, maps_->reshape(resMaps).broadcast(brdMaps));
   finishAdjoint(input(), time);
   return input();
 }
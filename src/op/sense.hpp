@@ -2,18 +2,21 @@
 
 #include "operator-alloc.hpp"
 
+#include <memory>
+
 namespace rl {
 
 struct SenseOp final : OperatorAlloc<Cx, 4, 5>
 {
   OPALLOC_INHERIT( Cx, 4, 5 )
   SenseOp(Cx4 const &maps, Index const d0);
+  SenseOp(std::shared_ptr<Cx4 const> maps, Index const d0); // Maps shared with other operators, e.g. volume workers
   OPALLOC_DECLARE()
   auto nChannels() const -> Index;
   auto mapDimensions() const -> Sz3;
 
 private:
-  Cx4 maps_;
+  std::shared_ptr<Cx4 const> maps_;
   Eigen::IndexList<FixOne, int, int, int, int> resX;
   Eigen::IndexList<int, FixOne, FixOne, FixOne, FixOne> brdX;
   Eigen::IndexList<int, FixOne, int, int, int> resMaps;
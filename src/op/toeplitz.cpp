@@ -0,0 +1,114 @@
+#include "toeplitz.hpp"
+
+#include "nufft.hpp"
+#include "tensorOps.hpp"
+#include "threads.hpp"
+
+namespace rl {
+
+ToeplitzOp::ToeplitzOp(
+  Trajectory const &traj,
+  std::string const &ktype,
+  float const osamp,
+  std::shared_ptr<Cx4 const> maps,
+  std::optional<Re2> const &basis,
+  std::shared_ptr<Functor<Cx3>> sdc,
+  Index const channelBlock)
+  : Parent(
+      "ToeplitzOp",
+      AddFront(LastN<3>(maps->dimensions()), basis ? basis.value().dimension(0) : 1),
+      AddFront(LastN<3>(maps->dimensions()), basis ? basis.value().dimension(0) : 1))
+  , maps_{maps}
+{
+  if (traj.nDims() != 3) {
+    Log::Fail("Töplitz embedding is only implemented for 3D trajectories");
+  }
+  Index const nC = maps_->dimension(0);
+  Index const nB = inputDimensions()[0];
+  Sz3 const mSz = LastN<3>(inputDimensions());
+  Sz3 const tSz{2 * mSz[0], 2 * mSz[1], 2 * mSz[2]};
+
+  // Split the channels into equal blocks of at most channelBlock
+  Index const nBlocks = channelBlock > 0 ? (nC + channelBlock - 1) / channelBlock : 1;
+  nBlock_ = (nC + nBlocks - 1) / nBlocks;
+
+  auto const start = Log::Now();
+  Log::Print("Calculating Töplitz embedding. Transfer function size {}", tSz);
+  // Doubling the oversampling at the same nominal matrix doubles the FOV, so the PSF is gridded onto a 2x matrix
+  auto grid = make_grid<Cx, 3>(traj, ktype, osamp * 2.f, 1, basis);
+  NUFFTOp<3> nufft(grid, tSz, sdc);
+  transfer_.resize(AddFront(tSz, nB, nB));
+  Cx5 delta(AddFront(tSz, 1, nB));
+  for (Index ib = 0; ib < nB; ib++) {
+    delta.setZero();
+    delta(0, ib, tSz[0] / 2, tSz[1] / 2, tSz[2] / 2) = 1.f;
+    auto y = nufft.forward(delta);
+    transfer_.chip<1>(ib) = nufft.adjoint(y).chip<0>(0);
+  }
+  // The FFTs are unitary, so the convolution theorem picks up a factor of sqrt(N)
+  auto const tfft = FFT::Make<5, 3>(transfer_.dimensions());
+  tfft->forward(Eigen::TensorMap<Cx5>(transfer_.data(), transfer_.dimensions()));
+  transfer_.device(Threads::GlobalDevice()) = transfer_ * transfer_.constant(std::sqrt(Product(tSz)));
+
+  ws_.resize(AddFront(tSz, nBlock_, nB));
+  if (nB > 1) {
+    temp_.resize(ws_.dimensions());
+  }
+  fft_ = FFT::Make<5, 3>(Eigen::TensorMap<Cx5>(ws_.data(), ws_.dimensions()), mSz); // Zero-padded, then cropped
+  left_ = Sz5{0, 0, (tSz[0] - mSz[0] + 1) / 2, (tSz[1] - mSz[1] + 1) / 2, (tSz[2] - mSz[2] + 1) / 2};
+  Log::Print(
+    FMT_STRING("Töplitz embedding took {}. {} channel blocks, workspace {:L} bytes"),
+    Log::ToNow(start),
+    nBlocks,
+    (ws_.size() + temp_.size()) * sizeof(Cx));
+}
+
+auto ToeplitzOp::forward(InputMap x) const -> OutputMap
+{
+  auto const time = startForward(x);
+  auto const &dev = Threads::GlobalDevice();
+  Index const nC = maps_->dimension(0);
+  Index const nB = x.dimension(0);
+  Sz3 const mSz = LastN<3>(inputDimensions());
+  Sz5 const wSz = ws_.dimensions();
+  output().device(dev) = output().constant(0.f);
+  for (Index c0 = 0; c0 < nC; c0 += nBlock_) {
+    Index const nCB = std::min(nBlock_, nC - c0);
+    Sz5 const bSz{nCB, nB, mSz[0], mSz[1], mSz[2]};
+    auto const maps = maps_->slice(Sz4{c0, 0, 0, 0}, AddFront(mSz, nCB))
+                        .reshape(Sz5{nCB, 1, mSz[0], mSz[1], mSz[2]})
+                        .broadcast(Sz5{1, nB, 1, 1, 1});
+    ws_.device(dev) = ws_.constant(0.f);
+    ws_.slice(left_, bSz).device(dev) =
+      maps * x.reshape(Sz5{1, nB, mSz[0], mSz[1], mSz[2]}).broadcast(Sz5{nCB, 1, 1, 1, 1});
+    fft_->forward(Eigen::TensorMap<Cx5>(ws_.data(), wSz));
+    if (nB == 1) {
+      ws_.device(dev) = ws_ * transfer_.broadcast(Sz5{wSz[0], 1, 1, 1, 1});
+    } else {
+      Sz4 const res{1, wSz[2], wSz[3], wSz[4]}, brd{wSz[0], 1, 1, 1};
+      for (Index ib = 0; ib < nB; ib++) {
+        temp_.chip<1>(ib).device(dev) = ws_.chip<1>(0) * transfer_.chip<1>(0).chip<0>(ib).reshape(res).broadcast(brd);
+        for (Index jb = 1; jb < nB; jb++) {
+          temp_.chip<1>(ib).device(dev) =
+            temp_.chip<1>(ib) + ws_.chip<1>(jb) * transfer_.chip<1>(jb).chip<0>(ib).reshape(res).broadcast(brd);
+        }
+      }
+      ws_.device(dev) = temp_;
+    }
+    fft_->reverse(Eigen::TensorMap<Cx5>(ws_.data(), wSz));
+    output().device(dev) = output() + ConjugateSum(ws_.slice(left_, bSz), maps);
+  }
+  finishForward(output(), time);
+  return output();
+}
+
+// The normal operator is self-adjoint
+auto ToeplitzOp::adjoint(OutputMap y) const -> InputMap
+{
+  auto const time = startAdjoint(y);
+  auto result = forward(y);
+  finishAdjoint(result, time);
+  return result;
+}
+
+} // namespace rl
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "operator-alloc.hpp"
+
+#include "fft/fft.hpp"
+#include "func/functor.hpp"
+#include "trajectory.hpp"
+
+#include <optional>
+
+namespace rl {
+
+/*
+ * The SENSE-NUFFT normal operator S'A'WAS evaluated with a Töplitz embedding. The point-spread function is gridded once
+ * onto a matrix of twice the size, after which each application is SENSE expand, zero-pad, FFT, multiply by the
+ * transfer function, inverse FFT, crop and SENSE combine. Channels are processed in blocks to bound the workspace.
+ */
+struct ToeplitzOp final : OperatorAlloc<Cx, 4, 4>
+{
+  OPALLOC_INHERIT(Cx, 4, 4)
+  ToeplitzOp(
+    Trajectory const &traj,
+    std::string const &ktype,
+    float const osamp,
+    std::shared_ptr<Cx4 const> maps,
+    std::optional<Re2> const &basis,
+    std::shared_ptr<Functor<Cx3>> sdc,
+    Index const channelBlock = 0);
+  OPALLOC_DECLARE()
+
+private:
+  std::shared_ptr<Cx4 const> maps_;
+  Cx5 transfer_;          // Indexed (b, b', k), couples basis vector b' of the input to b of the output
+  Cx5 mutable ws_, temp_; // temp_ is only needed when there is more than one basis vector
+  std::shared_ptr<FFT::FFT<5, 3>> fft_;
+  Sz5 left_;
+  Index nBlock_;
+};
+
+} // namespace rl
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "../log.hpp"
+#include "tensorOps.hpp"
+#include "types.hpp"
+
+#include <mutex>
+#include <vector>
+
+namespace rl {
+
+/*
+ * Scratch memory for operators, solvers and proxes that would otherwise allocate on every call or iteration.
+ *
+ * A Lease borrows a tensor from a pool shared by all tensors of the same type and gives it back when it goes out of
+ * scope. Tensors are matched on total size, so a solver that runs many times on the same problem only allocates the
+ * first time. The pool is thread-safe. Tensors that are given back are kept until the pool holds more than Limit bytes,
+ * then the least recently returned are freed, apart from the newest so that a single large tensor is still reused.
+ *
+ * ThreadScratch returns a map onto a per-thread buffer that only ever grows, for small temporaries inside parallel
+ * loops, e.g. the bucket grids. Only one map per tensor type and thread can be in use at a time.
+ */
+namespace Workspace {
+
+inline constexpr Index Limit = Index(1) << 30; // Bytes kept in each pool once its tensors are given back
+
+template <typename T>
+struct Lease
+{
+  using Dims = typename T::Dimensions;
+
+  Lease(Dims const &dims)
+    : t_{Take(dims)}
+  {
+  }
+
+  ~Lease() { Give(std::move(t_)); }
+
+  Lease(Lease const &) = delete;
+  Lease &operator=(Lease const &) = delete;
+
+  auto operator*() -> T & { return t_; }
+  auto operator->() -> T * { return &t_; }
+
+private:
+  struct Pool
+  {
+    std::mutex mutex;
+    std::vector<T> free; // Oldest first
+    Index bytes = 0;
+  };
+
+  static auto GetPool() -> Pool &
+  {
+    static Pool pool;
+    return pool;
+  }
+
+  static auto Take(Dims const &dims) -> T
+  {
+    Index const sz = Product(dims);
+    auto &pool = GetPool();
+    {
+      std::scoped_lock lock(pool.mutex);
+      // Most recently returned first, as it is most likely still in cache
+      for (auto it = pool.free.rbegin(); it != pool.free.rend(); it++) {
+        if (it->size() == sz) {
+          T t = std::move(*it);
+          pool.free.erase(std::next(it).base());
+          pool.bytes -= sz * sizeof(typename T::Scalar);
+          t.resize(dims); // Same size so no allocation
+          return t;
+        }
+      }
+    }
+    Log::Print<Log::Level::Debug>(FMT_STRING("Workspace allocated {:L} bytes"), sz * sizeof(typename T::Scalar));
+    return T(dims);
+  }
+
+  static void Give(T &&t)
+  {
+    auto &pool = GetPool();
+    std::scoped_lock lock(pool.mutex);
+    pool.bytes += t.size() * sizeof(typename T::Scalar);
+    pool.free.push_back(std::move(t));
+    if (pool.bytes > Limit && pool.free.size() > 1) {
+      auto it = pool.free.begin();
+      for (; pool.bytes > Limit && std::next(it) != pool.free.end(); it++) {
+        pool.bytes -= it->size() * sizeof(typename T::Scalar);
+      }
+      Log::Print<Log::Level::Debug>(
+        FMT_STRING("Workspace freed {} tensors, retaining {:L} bytes"),
+        std::distance(pool.free.begin(), it),
+        pool.bytes);
+      pool.free.erase(pool.free.begin(), it);
+    }
+  }
+
+  T t_;
+};
+
+template <typename T>
+auto ThreadScratch(typename T::Dimensions const &dims) -> Eigen::TensorMap<T>
+{
+  thread_local std::vector<typename T::Scalar> buffer;
+  Index const sz = Product(dims);
+  if ((Index)buffer.size() < sz) {
+    buffer.resize(sz);
+  }
+  return Eigen::TensorMap<T>(buffer.data(), dims);
+}
+
+} // namespace Workspace
+} // namespace rl
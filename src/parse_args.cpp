@@ -1,6 +1,9 @@
 #include "parse_args.hpp"
 #include "io/hd5.hpp"
 #include "io/writer.hpp"
+#include "op/gridBase.hpp"
+#include "op/nufft.hpp"
+#include "plan-cache.hpp"
 #include "tensorOps.hpp"
 #include "threads.hpp"
 #include <algorithm>
@@ -71,7 +74,7 @@ void Sz3Reader::operator()(std::string const &name, std::string const &value, Sz
 CoreOpts::CoreOpts(args::Subparser &parser)
   : iname(parser, "F", "Input HD5 file")
   , oname(parser, "O", "Override output name", {'o', "out"})
-  , ktype(parser, "K", "Choose kernel - NN, KB3, KB5", {'k', "kernel"}, "ES3")
+  , ktype(parser, "K", "Choose kernel - NN, KB3, KB5, ES3, ES5, append -lut for tabulated", {'k', "kernel"}, "ES3")
   , osamp(parser, "O", "Grid oversampling factor (2)", {'s', "osamp"}, 2.f)
   , fov(parser, "FOV", "Final FoV in mm (default header value)", {"fov"}, -1)
   , bucketSize(parser, "B", "Gridding bucket size (32)", {"bucket-size"}, 32)
@@ -85,7 +88,21 @@ args::HelpFlag help(global_group, "H", "Show this help message", {'h', "help"});
 args::Flag verbose(global_group, "V", "Print logging messages to stdout", {'v', "verbose"});
 args::MapFlag<int, Log::Level> verbosity(global_group, "V", "Talk more (values 0-3)", {"verbosity"}, levelMap);
 args::ValueFlag<std::string> debug(global_group, "F", "Write debug images to file", {"debug"});
-args::ValueFlag<Index> nthreads(global_group, "N", "Limit number of threads", {"nthreads"});
+args::ValueFlag<Index>
+  nthreads(global_group, "N", "Limit all stages, including FFTs, to N threads in total", {"nthreads", "max-cores"});
+args::Flag pinThreads(global_group, "P", "Pin threads to cores, filling one NUMA node first", {"pin-threads"});
+args::ValueFlag<Index> kernelCache(global_group, "M", "Cache gridding kernel weights up to M MB", {"kernel-cache"});
+args::ValueFlag<Index>
+  nufftMem(global_group, "M", "Limit NUFFT workspaces to M MB by gridding channels in blocks", {"nufft-mem"});
+args::Flag gridSorted(global_group, "G", "Copy non-cartesian data into gridding order first", {"grid-sorted"});
+args::Flag
+  gridSubspace(global_group, "S", "Apply the basis to per-timepoint grids with a GEMM where cheaper", {"grid-subspace"});
+args::ValueFlag<Index>
+  sliceWorkers(global_group, "N", "Process N slices of 2D multi-slice data concurrently, each with its own workspace (1, 0 = auto)", {"slice-workers"});
+args::Flag sliceBatch(global_group, "B", "Stack all slices of 2D multi-slice data into one NUFFT", {"slice-batch"});
+args::ValueFlag<int> compress(global_group, "L", "HDF5 deflate level for output, 0 disables (2)", {"compress"});
+args::Flag shuffle(global_group, "S", "Apply HDF5 shuffle filter before deflate", {"shuffle"});
+args::ValueFlag<std::string> planCache(global_group, "D", "Cache mappings, apodization and SDC in directory D", {"plan-cache"});
 
 void SetLogging(std::string const &name)
 {
@@ -107,19 +124,70 @@ void SetLogging(std::string const &name)
 
 void SetThreadCount()
 {
+  bool const pin = pinThreads || std::getenv("RL_PIN_THREADS");
   if (nthreads) {
-    Threads::SetGlobalThreadCount(nthreads.Get());
+    Threads::SetGlobalThreadCount(nthreads.Get(), pin);
   } else if (char *const env_p = std::getenv("RL_THREADS")) {
-    Threads::SetGlobalThreadCount(std::atoi(env_p));
+    Threads::SetGlobalThreadCount(std::atoi(env_p), pin);
+  } else if (pin) {
+    Threads::SetGlobalThreadCount(0, pin);
   }
   Log::Print(FMT_STRING("Using {} threads"), Threads::GlobalThreadCount());
 }
 
+void SetGridOptions()
+{
+  GridOpts o;
+  if (kernelCache) {
+    o.kernelCache = kernelCache.Get();
+  } else if (char *const env_p = std::getenv("RL_KERNEL_CACHE")) {
+    o.kernelCache = std::atoi(env_p);
+  }
+  o.sorted = gridSorted || std::getenv("RL_GRID_SORTED");
+  o.subspace = gridSubspace || std::getenv("RL_GRID_SUBSPACE");
+  if (nufftMem) {
+    o.nufftMemory = nufftMem.Get();
+  } else if (char *const env_p = std::getenv("RL_NUFFT_MEM")) {
+    o.nufftMemory = std::atoi(env_p);
+  }
+  if (sliceWorkers) {
+    o.sliceWorkers = sliceWorkers.Get();
+  } else if (char *const env_p = std::getenv("RL_SLICE_WORKERS")) {
+    o.sliceWorkers = std::atoi(env_p);
+  }
+  o.sliceBatch = sliceBatch || std::getenv("RL_SLICE_BATCH");
+  SetGridDefaults(o);
+}
+
+void SetCompression()
+{
+  HD5::Compression c;
+  if (compress) {
+    c.level = compress.Get();
+  } else if (char *const env_p = std::getenv("RL_COMPRESS")) {
+    c.level = std::atoi(env_p);
+  }
+  c.shuffle = shuffle;
+  HD5::SetCompression(c);
+}
+
+void SetPlanCache()
+{
+  if (planCache) {
+    PlanCache::SetDirectory(planCache.Get());
+  } else if (char *const env_p = std::getenv("RL_PLAN_CACHE")) {
+    PlanCache::SetDirectory(env_p);
+  }
+}
+
 void ParseCommand(args::Subparser &parser, args::Positional<std::string> &iname)
 {
   parser.Parse();
   SetLogging(parser.GetCommand().Name());
   SetThreadCount();
+  SetGridOptions();
+  SetCompression();
+  SetPlanCache();
   if (!iname) {
     throw args::Error("No input file specified");
   }
@@ -130,6 +198,9 @@ void ParseCommand(args::Subparser &parser)
   parser.Parse();
   SetLogging(parser.GetCommand().Name());
   SetThreadCount();
+  SetGridOptions();
+  SetCompression();
+  SetPlanCache();
 }
 
 auto ReadBasis(std::string const &basisFile) -> std::optional<Re2>
@@ -166,6 +237,15 @@ OutName(std::string const &iName, std::string const &oName, std::string const &s
     extension);
 }
 
+void WriteTrajectory(HD5::Writer &writer, bool const keepTrajectory, rl::Trajectory const &traj)
+{
+  if (keepTrajectory) {
+    traj.write(writer);
+  } else {
+    writer.writeInfo(traj.info());
+  }
+}
+
 void WriteOutput(
   Cx5 const &img,
   std::string const &iname,
@@ -177,9 +257,5 @@ void WriteOutput(
   auto const fname = OutName(iname, oname, suffix, "h5");
   HD5::Writer writer(fname);
   writer.writeTensor(img, HD5::Keys::Image);
-  if (keepTrajectory) {
-    traj.write(writer);
-  } else {
-    writer.writeInfo(traj.info());
-  }
+  WriteTrajectory(writer, keepTrajectory, traj);
 }
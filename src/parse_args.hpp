@@ -41,6 +41,7 @@ auto ReadBasis(std::string const &basisFile) -> std::optional<rl::Re2>;
 std::string OutName(
   std::string const &iName, std::string const &oName, std::string const &suffix, std::string const &extension = "h5");
 
+void WriteTrajectory(rl::HD5::Writer &writer, bool const keepTrajectory, rl::Trajectory const &traj);
 void WriteOutput(
   rl::Cx5 const &img,
   std::string const &iname,
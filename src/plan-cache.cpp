@@ -0,0 +1,188 @@
+#include "plan-cache.hpp"
+
+#include "log.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rl {
+namespace PlanCache {
+
+namespace {
+std::filesystem::path directory;
+
+struct Header
+{
+  char magic[8] = {'R', 'L', 'P', 'L', 'A', 'N', '0', '1'}; // Bump the version if the layout of any entry changes
+  uint64_t key = 0;
+  uint64_t bytes = 0;
+};
+
+auto EntryPath(std::string const &kind, Key const &key) -> std::filesystem::path
+{
+  return directory / fmt::format(FMT_STRING("{}-{:016x}.plan"), kind, key.hash);
+}
+} // namespace
+
+void SetDirectory(std::string const &dir)
+{
+  directory = dir;
+  if (directory.empty()) {
+    return;
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+  if (ec) {
+    Log::Print(FMT_STRING("Could not create plan cache directory {}: {}, continuing without"), dir, ec.message());
+    directory.clear();
+  } else {
+    Log::Print(FMT_STRING("Using plan cache in {}"), directory.string());
+  }
+}
+
+auto Enabled() -> bool
+{
+  return !directory.empty();
+}
+
+auto Key::add(void const *data, size_t const bytes) -> Key &
+{
+  uint64_t constexpr prime = 1099511628211ULL;
+  auto const *p = static_cast<char const *>(data);
+  size_t const words = bytes / sizeof(uint64_t);
+  for (size_t ii = 0; ii < words; ii++) {
+    uint64_t w;
+    std::memcpy(&w, p + ii * sizeof(uint64_t), sizeof(uint64_t));
+    hash = (hash ^ w) * prime;
+  }
+  for (size_t ii = words * sizeof(uint64_t); ii < bytes; ii++) {
+    hash = (hash ^ static_cast<unsigned char>(p[ii])) * prime;
+  }
+  hash = (hash ^ bytes) * prime; // So that adjacent fields cannot run into each other
+  return *this;
+}
+
+auto Key::add(std::string const &s) -> Key &
+{
+  return add(s.data(), s.size());
+}
+
+void Blob::put(void const *data, size_t const n)
+{
+  auto const *p = static_cast<char const *>(data);
+  bytes.insert(bytes.end(), p, p + n);
+}
+
+Entry::Entry(char const *data, size_t const size)
+  : data_{data}
+  , size_{size}
+  , pos_{0}
+{
+}
+
+void Entry::get(void *data, size_t const bytes)
+{
+  if (bytes > size_ - pos_) {
+    throw Log::Failure(fmt::format(FMT_STRING("Plan cache entry truncated, wanted {} bytes with {} left"), bytes, size_ - pos_));
+  }
+  std::memcpy(data, data_ + pos_, bytes);
+  pos_ += bytes;
+}
+
+void Entry::require(Index const n, size_t const bytes) const
+{
+  if (n < 0 || (bytes > 0 && size_t(n) > (size_ - pos_) / bytes)) {
+    throw Log::Failure(
+      fmt::format(FMT_STRING("Plan cache entry corrupt, wanted {} items of {} bytes with {} left"), n, bytes, size_ - pos_));
+  }
+}
+
+auto Entry::finished() const -> bool
+{
+  return pos_ == size_;
+}
+
+auto Load(std::string const &kind, Key const &key, std::function<void(Entry &)> const &f) -> bool
+{
+  if (!Enabled()) {
+    return false;
+  }
+  auto const start = Log::Now();
+  auto const path = EntryPath(kind, key);
+  int const fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    Log::Print<Log::Level::High>(FMT_STRING("No {} plan in cache"), kind);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header)) {
+    close(fd);
+    return false;
+  }
+  void *const map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  bool ok = false;
+  Header h;
+  Header const ref;
+  std::memcpy(&h, map, sizeof(Header));
+  if (std::memcmp(h.magic, ref.magic, sizeof(h.magic)) || h.key != key.hash || h.bytes != st.st_size - sizeof(Header)) {
+    Log::Print(FMT_STRING("Ignoring stale plan cache entry {}"), path.string());
+  } else {
+    Entry e(static_cast<char const *>(map) + sizeof(Header), h.bytes);
+    try {
+      f(e);
+      ok = e.finished();
+    } catch (Log::Failure const &err) {
+      Log::Print(FMT_STRING("Could not read plan cache entry {}: {}"), path.string(), err.what());
+    }
+  }
+  munmap(map, st.st_size);
+  if (ok) {
+    Log::Print(FMT_STRING("Loaded {} plan from cache in {}"), kind, Log::ToNow(start));
+  }
+  return ok;
+}
+
+void Store(std::string const &kind, Key const &key, Blob const &blob)
+{
+  if (!Enabled()) {
+    return;
+  }
+  auto const path = EntryPath(kind, key);
+  // Write to a temporary and rename so concurrent readers never see a partial entry
+  auto tmp = path;
+  tmp += fmt::format(FMT_STRING(".{}"), getpid());
+  Header h;
+  h.key = key.hash;
+  h.bytes = blob.bytes.size();
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    out.write(reinterpret_cast<char const *>(&h), sizeof(Header));
+    out.write(blob.bytes.data(), blob.bytes.size());
+    if (!out) {
+      Log::Print(FMT_STRING("Failed to write plan cache entry {}"), tmp.string());
+      std::error_code ec;
+      std::filesystem::remove(tmp, ec);
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    Log::Print(FMT_STRING("Failed to store plan cache entry {}: {}"), path.string(), ec.message());
+    std::filesystem::remove(tmp, ec);
+  } else {
+    Log::Print<Log::Level::High>(FMT_STRING("Stored {} plan in cache"), kind);
+  }
+}
+
+} // namespace PlanCache
+} // namespace rl
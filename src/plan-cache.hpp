@@ -0,0 +1,134 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rl {
+
+/*
+ * On-disk cache for set-up work that depends only on the trajectory and gridding parameters, e.g. the Mapping,
+ * apodization and Pipe SDC. Entries are keyed by a hash of everything that determines them and are memory-mapped when
+ * loaded. Similar in spirit to FFTW wisdom, but disabled unless a directory is set. Only plain-old-data is stored.
+ */
+namespace PlanCache {
+
+void SetDirectory(std::string const &dir); // Empty disables the cache
+auto Enabled() -> bool;
+
+struct Key
+{
+  uint64_t hash = 14695981039346656037ULL; // FNV-1a, applied to 8-byte words
+
+  auto add(void const *data, size_t const bytes) -> Key &;
+  auto add(std::string const &s) -> Key &;
+
+  template <typename T>
+  auto add(T const &v) -> Key &
+  {
+    return add(&v, sizeof(T));
+  }
+
+  template <typename T, int N>
+  auto add(Eigen::Tensor<T, N> const &t) -> Key &
+  {
+    add(t.dimensions());
+    return add(t.data(), t.size() * sizeof(T));
+  }
+};
+
+// Serializes an entry before it is stored
+struct Blob
+{
+  std::vector<char> bytes;
+
+  void put(void const *data, size_t const bytes);
+
+  template <typename T>
+  void put(T const &v)
+  {
+    put(&v, sizeof(T));
+  }
+
+  template <typename T>
+  void putVector(std::vector<T> const &v)
+  {
+    put<uint64_t>(v.size());
+    put(v.data(), v.size() * sizeof(T));
+  }
+};
+
+// Reads back a memory-mapped entry. Reading past the end throws, which Load reports as a miss
+struct Entry
+{
+  Entry(char const *data, size_t const size);
+
+  void get(void *data, size_t const bytes);
+  // Throws unless n items of the given size are left, so that a corrupt length fails before anything is allocated
+  void require(Index const n, size_t const bytes) const;
+
+  template <typename T>
+  auto get() -> T
+  {
+    T v;
+    get(&v, sizeof(T));
+    return v;
+  }
+
+  template <typename T>
+  auto getVector() -> std::vector<T>
+  {
+    auto const n = get<uint64_t>();
+    require(n, sizeof(T));
+    std::vector<T> v(n);
+    get(v.data(), v.size() * sizeof(T));
+    return v;
+  }
+
+  auto finished() const -> bool;
+
+private:
+  char const *data_;
+  size_t size_, pos_;
+};
+
+// Returns true if an entry was found and f consumed all of it
+auto Load(std::string const &kind, Key const &key, std::function<void(Entry &)> const &f) -> bool;
+void Store(std::string const &kind, Key const &key, Blob const &blob);
+
+template <typename T, int N>
+auto LoadTensor(std::string const &kind, Key const &key) -> std::optional<Eigen::Tensor<T, N>>
+{
+  std::optional<Eigen::Tensor<T, N>> t;
+  if (!Load(kind, key, [&](Entry &e) {
+        auto const dims = e.get<Eigen::DSizes<Index, N>>();
+        size_t bytes = sizeof(T);
+        for (auto const d : dims) {
+          e.require(d, bytes);
+          bytes *= d;
+        }
+        t.emplace(dims);
+        e.get(t->data(), t->size() * sizeof(T));
+      })) {
+    t.reset();
+  }
+  return t;
+}
+
+template <typename T, int N>
+void StoreTensor(std::string const &kind, Key const &key, Eigen::Tensor<T, N> const &t)
+{
+  if (!Enabled()) {
+    return;
+  }
+  Blob b;
+  b.put(t.dimensions());
+  b.put(t.data(), t.size() * sizeof(T));
+  Store(kind, key, b);
+}
+
+} // namespace PlanCache
+} // namespace rl
@@ -5,6 +5,7 @@
 #include "io/hd5.hpp"
 #include "mapping.hpp"
 #include "op/make_grid.hpp"
+#include "plan-cache.hpp"
 #include "tensorOps.hpp"
 #include "threads.hpp"
 #include "trajectory.hpp"
@@ -24,6 +25,13 @@ template <int ND>
 auto Pipe(Trajectory const &traj, std::string const &ktype, float const os, Index const its, float const pow) -> Re2
 {
   Log::Print(FMT_STRING("Using Pipe/Zwart/Menon SDC..."));
+  PlanCache::Key key;
+  if (PlanCache::Enabled()) {
+    key.add(fmt::format("Pipe<{}> {}", ND, ktype)).add(traj.info().matrix).add(traj.points()).add(os).add(its).add(pow);
+    if (auto W = PlanCache::LoadTensor<float, 2>("sdc", key); W && W->dimensions() == Sz2{traj.nSamples(), traj.nTraces()}) {
+      return *W;
+    }
+  }
   Re3 W(1, traj.nSamples(), traj.nTraces());
   Re3 Wp(W.dimensions());
   auto gridder = make_grid<float, ND>(traj, ktype, os, 1);
@@ -42,7 +50,9 @@ auto Pipe(Trajectory const &traj, std::string const &ktype, float const os, Inde
     }
   }
   Log::Print(FMT_STRING("SDC finished."));
-  return W.chip<0>(0).pow(pow);
+  Re2 const sdc = W.chip<0>(0).pow(pow);
+  PlanCache::StoreTensor("sdc", key, sdc);
+  return sdc;
 }
 
 Re2 Radial2D(Trajectory const &traj)
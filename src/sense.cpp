@@ -42,8 +42,11 @@ Cx4 SelfCalibration(Opts &opts, CoreOpts &coreOpts, Trajectory const &inTraj, HD
     Log::Fail("Specified SENSE volume {} is greater than number of volumes in data {}", opts.volume.Get(), nV);
   }
 
-  Cx4 const data = reader.readSlab<Cx4>(HD5::Keys::Noncartesian, opts.volume.Get());
-  Cx4 lores = data.slice(Sz4{0, lo, 0, 0}, Sz4{nC, sz, data.dimension(2), data.dimension(3)});
+  auto const kDims = reader.dimensions<5>(HD5::Keys::Noncartesian);
+  Cx4 lores = reader
+                .readSlice<Cx5>(
+                  HD5::Keys::Noncartesian, Sz5{0, lo, 0, 0, opts.volume.Get()}, Sz5{nC, sz, kDims[2], kDims[3], 1})
+                .chip<4>(0);
   auto const maxCoord = Maximum(NoNaNs(traj.points()).abs());
 NoncartesianTukey(maxCoord * 0.75, maxCoord, 0.f, traj.points(), lores);
   Cx5 const allChan = nufft->adjoint(lores);
@@ -16,30 +16,162 @@
 #include <unsupported/Eigen/CXX11/Tensor>
 #include <unsupported/Eigen/CXX11/ThreadPool>
 
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace {
-Eigen::ThreadPool *gp = nullptr;
+Eigen::ThreadPoolInterface *gp = nullptr;
+
+#ifdef __linux__
+// Parses a sysfs cpulist such as "0-15,32-47"
+std::vector<int> ParseCPUList(std::string const &list)
+{
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    auto const dash = range.find('-');
+    int const lo = std::stoi(range.substr(0, dash));
+    int const hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+    for (int ii = lo; ii <= hi; ii++) {
+      cpus.push_back(ii);
+    }
+  }
+  return cpus;
+}
+
+// The CPUs this process may run on, ordered so that all the CPUs of one NUMA node come before the next
+std::vector<int> PinOrder()
+{
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  sched_getaffinity(0, sizeof(allowed), &allowed);
+  std::vector<int> order;
+  std::filesystem::path const nodes("/sys/devices/system/node");
+  for (int node = 0; std::filesystem::exists(nodes / fmt::format("node{}", node)); node++) {
+    std::ifstream f(nodes / fmt::format("node{}", node) / "cpulist");
+    std::string list;
+    std::getline(f, list);
+    if (!list.empty()) {
+      for (auto const cpu : ParseCPUList(list)) {
+        if (CPU_ISSET(cpu, &allowed)) {
+          order.push_back(cpu);
+        }
+      }
+    }
+  }
+  if (order.empty()) { // No NUMA information
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        order.push_back(cpu);
+      }
+    }
+  }
+  return order;
+}
+
+// Eigen thread environment that pins each new thread to the next CPU in order
+struct PinnedEnvironment : Eigen::StlThreadEnvironment
+{
+  std::vector<int> cpus = PinOrder();
+  std::shared_ptr<std::atomic<size_t>> next = std::make_shared<std::atomic<size_t>>(0);
+
+  EnvThread *CreateThread(std::function<void()> f)
+  {
+    int const cpu = cpus[(*next)++ % cpus.size()];
+    return new EnvThread([f = std::move(f), cpu]() {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+      f();
+    });
+  }
+};
+#endif
+
+// Runs chunk(0..nChunks-1) with one task per thread and waits for them to finish
+void RunChunks(std::function<void(Index)> const &chunk, Index const nChunks, rl::Threads::Schedule const s)
+{
+  Index const nt = gp->NumThreads();
+  if (nt == 1 || nChunks <= 1) {
+    for (Index ic = 0; ic < nChunks; ic++) {
+      chunk(ic);
+    }
+    return;
+  }
+  // One task per thread rather than per index keeps the scheduling overhead independent of the loop size
+  Index const nTasks = std::min(nt, nChunks);
+  Eigen::Barrier barrier(static_cast<unsigned int>(nTasks));
+  std::atomic<Index> next = 0;
+  for (Index it = 0; it < nTasks; it++) {
+    gp->Schedule([&, it] {
+      if (s == rl::Threads::Schedule::Static) {
+        for (Index ic = it * nChunks / nTasks; ic < (it + 1) * nChunks / nTasks; ic++) {
+          chunk(ic);
+        }
+      } else {
+        for (Index ic = next++; ic < nChunks; ic = next++) {
+          chunk(ic);
+        }
+      }
+      barrier.Notify();
+    });
+  }
+  barrier.Wait();
 }
+} // namespace
 
 namespace rl {
 namespace Threads {
 
-Eigen::ThreadPool *GlobalPool()
+Index AvailableCores()
+{
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    return CPU_COUNT(&allowed);
+  }
+#endif
+  return std::thread::hardware_concurrency();
+}
+
+Eigen::ThreadPoolInterface *GlobalPool()
 {
   if (gp == nullptr) {
-    auto const nt = std::thread::hardware_concurrency();
+    auto const nt = AvailableCores();
     Log::Print<Log::Level::High>(FMT_STRING("Creating default thread pool with {} threads"), nt);
     gp = new Eigen::ThreadPool(nt);
   }
   return gp;
 }
 
-void SetGlobalThreadCount(Index nt)
+void SetGlobalThreadCount(Index nt, bool const pin)
 {
   if (gp) {
     delete gp;
   }
   if (nt < 1) {
-    nt = std::thread::hardware_concurrency();
+    nt = AvailableCores();
+  }
+  if (pin) {
+#ifdef __linux__
+    PinnedEnvironment env;
+    Log::Print<Log::Level::High>(FMT_STRING("Creating thread pool with {} threads pinned to CPUs {}"), nt, fmt::join(env.cpus, ","));
+    gp = new Eigen::ThreadPoolTempl<PinnedEnvironment>(nt, env);
+    return;
+#else
+    Log::Print(FMT_STRING("Thread pinning is only supported on Linux"));
+#endif
   }
   Log::Print<Log::Level::High>(FMT_STRING("Creating thread pool with {} threads"), nt);
   gp = new Eigen::ThreadPool(nt);
@@ -55,33 +187,47 @@ Eigen::ThreadPoolDevice GlobalDevice()
   return Eigen::ThreadPoolDevice(GlobalPool(), GlobalPool()->NumThreads());
 }
 
-void For(ForFunc f, Index const lo, Index const hi, std::string const &label)
+void For(ForFunc f, Index const lo, Index const hi, Index const grain, Schedule const s, std::string const &label)
 {
   Index const ni = hi - lo;
-  Index const nt = GlobalPool()->NumThreads();
+  GlobalPool();
   if (ni == 0) {
     return;
   }
-  
-  Log::StartProgress(ni, label);
-  if (nt == 1) {
-    for (Index ii = lo; ii < hi; ii++) {
+
+  bool const progress = Log::StartProgress(ni, label);
+  Index const nChunks = (ni + grain - 1) / grain;
+  RunChunks(
+    [&](Index const ic) {
+      Index const cLo = lo + ic * grain;
+      Index const cHi = std::min(cLo + grain, hi);
+      for (Index ii = cLo; ii < cHi; ii++) {
+        f(ii);
+      }
+      if (progress) {
+        Log::Tick(cHi - cLo);
+      }
+    },
+    nChunks, s);
+  if (progress) {
+    Log::StopProgress();
+  }
+}
+
+void Parallel(ForFunc f, Index const n)
+{
+  if (GlobalPool()->CurrentThreadId() >= 0) {
+    for (Index ii = 0; ii < n; ii++) {
       f(ii);
-      Log::Tick();
     }
   } else {
-    Eigen::Barrier barrier(static_cast<unsigned int>(ni));
-    for (Index ii = lo; ii < hi; ii++) {
-      GlobalPool()->Schedule([&barrier, &f, ii] {
-        f(ii);
-        barrier.Notify();
-        Log::Tick();
-      });
-    }
-    barrier.Wait();
-
+    RunChunks(f, n, Schedule::Dynamic);
   }
-  Log::StopProgress();
+}
+
+void For(ForFunc f, Index const lo, Index const hi, std::string const &label)
+{
+  For(f, lo, hi, 1, Schedule::Dynamic, label);
 }
 
 void For(ForFunc f, Index const n, std::string const &label)
@@ -89,5 +235,13 @@ void For(ForFunc f, Index const n, std::string const &label)
   For(f, 0, n, label);
 }
 
+void For(ForFunc f, std::vector<Index> const &cost, std::string const &label)
+{
+  std::vector<Index> order(cost.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](Index const a, Index const b) { return cost[a] > cost[b]; });
+  For([&](Index const ii) { f(order[ii]); }, 0, order.size(), 1, Schedule::Dynamic, label);
+}
+
 } // namespace Threads
 } // namespace rl
@@ -12,13 +12,35 @@ namespace rl {
 
 namespace Threads {
 
+Index AvailableCores(); // CPUs in this process's affinity mask, which batch schedulers use to share nodes
 Index GlobalThreadCount();
-void SetGlobalThreadCount(Index n_threads);
+void SetGlobalThreadCount(Index n_threads, bool const pin = false); // pin threads to cores, one NUMA node at a time
 Eigen::ThreadPoolDevice GlobalDevice();
 
+/*
+ * Parallel loops. Each thread in the pool takes chunks of grain indices. With Dynamic scheduling threads take the next
+ * chunk from a shared counter as they finish, so faster threads pick up the slack. With Static each thread gets one
+ * contiguous block of chunks, which has the least overhead when every index costs the same. The cost version runs
+ * the most expensive indices first so that the cheap ones fill in the gaps at the end.
+ */
+enum struct Schedule
+{
+  Dynamic,
+  Static
+};
+
 using ForFunc = std::function<void(Index const index)>;
 void For(ForFunc f, Index const n, std::string const &label);
 void For(ForFunc f, Index const lo, Index const hi, std::string const &label);
+void For(ForFunc f, Index const lo, Index const hi, Index const grain, Schedule const s, std::string const &label);
+void For(ForFunc f, std::vector<Index> const &cost, std::string const &label);
+
+/*
+ * Runs f(0..n-1) on the global pool without progress reporting, for the parallel loops inside libraries such as FFTW so
+ * that every stage shares one set of threads. Called from a pool thread the loop runs serially, as waiting there would
+ * tie up a worker that the loop itself might need.
+ */
+void Parallel(ForFunc f, Index const n);
 
 } // namespace Threads
 } // namespace rl
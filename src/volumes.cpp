@@ -0,0 +1,83 @@
+#include "volumes.hpp"
+
+#include "log.hpp"
+
+#include <atomic>
+#include <future>
+#include <mutex>
+
+namespace rl {
+
+void ForVolumes(
+  HD5::Reader const &reader,
+  std::string const &label,
+  std::vector<VolumeFunc> const &workers,
+  HD5::Writer &writer,
+  std::string const &outLabel)
+{
+  Index const volumes = reader.dimensions<5>(label)[4];
+  std::atomic<Index> next = 0;
+  std::mutex ioMutex; // HDF5 is not thread-safe, so reads and writes share a lock
+  auto read = [&](Index const iv) {
+    std::scoped_lock lock(ioMutex);
+    return reader.readSlab<Cx4>(label, iv);
+  };
+  auto write = [&](Index const iv, Cx4 const &result) {
+    std::scoped_lock lock(ioMutex);
+    writer.writeSlab(result, iv, outLabel);
+  };
+
+  auto work = [&](VolumeFunc const &f) {
+    Index iv = next++;
+    std::future<Cx4> data;
+    std::future<void> written;
+    if (iv < volumes) {
+      data = std::async(std::launch::async, read, iv);
+    }
+    while (iv < volumes) {
+      Cx4 const current = data.get();
+      Index const nextV = next++;
+      if (nextV < volumes) {
+        data = std::async(std::launch::async, read, nextV);
+      }
+      auto const start = Log::Now();
+      Cx4 result = f(iv, current);
+      Log::Print(FMT_STRING("Volume {}: {}"), iv, Log::ToNow(start));
+      if (written.valid()) {
+        written.get();
+      }
+      written = std::async(std::launch::async, [&write, iv, r = std::move(result)]() { write(iv, r); });
+      iv = nextV;
+    }
+    if (written.valid()) {
+      written.get();
+    }
+  };
+
+  auto const start = Log::Now();
+  if (workers.size() == 1) {
+    work(workers.front());
+  } else {
+    Log::Print(FMT_STRING("Processing {} volumes with {} workers"), volumes, workers.size());
+    std::vector<std::future<void>> running;
+    for (auto const &f : workers) {
+      running.push_back(std::async(std::launch::async, work, std::cref(f)));
+    }
+    for (auto &r : running) {
+      r.get();
+    }
+  }
+  Log::Print(FMT_STRING("All Volumes: {}"), Log::ToNow(start));
+}
+
+void ForVolumes(
+  HD5::Reader const &reader,
+  std::string const &label,
+  VolumeFunc const &f,
+  HD5::Writer &writer,
+  std::string const &outLabel)
+{
+  ForVolumes(reader, label, std::vector<VolumeFunc>{f}, writer, outLabel);
+}
+
+} // namespace rl
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "io/reader.hpp"
+#include "io/writer.hpp"
+#include "types.hpp"
+
+#include <functional>
+
+namespace rl {
+
+/*
+ * Runs a function over every volume of a dataset and streams each result into a pre-created dataset (see
+ * HD5::Writer::createTensor), so only the volumes in flight are held in memory. Each worker reads its next volume in
+ * the background while the current one is processed. With more than one worker volumes are processed concurrently,
+ * so each worker must own its operators.
+ */
+using VolumeFunc = std::function<Cx4(Index const iv, Cx4 const &data)>;
+void ForVolumes(
+  HD5::Reader const &reader,
+  std::string const &label,
+  std::vector<VolumeFunc> const &workers,
+  HD5::Writer &writer,
+  std::string const &outLabel);
+void ForVolumes(
+  HD5::Reader const &reader,
+  std::string const &label,
+  VolumeFunc const &f,
+  HD5::Writer &writer,
+  std::string const &outLabel);
+
+} // namespace rl
@@ -55,5 +55,43 @@ TEST_CASE("FFT3","[FFT]")
     CHECK(Norm(data - ref) == Approx(0.f).margin(1.e-6f * N * nc));
   }
 
+  SECTION("Pruned")
+  {
+    Index const nc = 4;
+    Index const sz = 2 * sx;
+    Sz3 const active{sx / 2 + 1, sy / 2 + 1, sz / 2 + 1};
+    Sz5 const left{0, 0, (sx - active[0] + 1) / 2, (sy - active[1] + 1) / 2, (sz - active[2] + 1) / 2};
+    Sz5 const aSz{nc, 1, active[0], active[1], active[2]};
+    Cx5 data(nc, 1, sx, sy, sz), ref(nc, 1, sx, sy, sz), img(aSz);
+    auto const fft = FFT::Make<5, 3>(ref.dimensions());
+    auto const pruned = FFT::Make<5, 3>(data, active);
+
+    img.setRandom();
+    ref.setZero();
+    ref.slice(left, aSz) = img;
+    data = ref;
+    fft->forward(ref);
+    pruned->forward(data);
+    CHECK(Norm(data - ref) == Approx(0.f).margin(1.e-4f * Norm(ref)));
+    pruned->reverse(data);
+    CHECK(Norm(data.slice(left, aSz) - img) == Approx(0.f).margin(1.e-4f * Norm(img)));
+  }
+
+  SECTION("Shared plans")
+  {
+    Index const sz = 8;
+    Cx3 a(sx, sy, sz), b(sx, sy, sz);
+    auto const first = FFT::Make<3, 3>(a.dimensions());
+    auto const second = FFT::Make<3, 3>(b); // Same shape and alignment, so the plans are shared
+    a.setRandom();
+    b = a;
+    Cx3 const orig = a;
+    first->forward(a);
+    second->forward(b);
+    CHECK(Norm(a - b) == Approx(0.f).margin(1.e-6f * Norm(a)));
+    second->reverse(a);
+    CHECK(Norm(a - orig) == Approx(0.f).margin(1.e-4f * Norm(orig)));
+  }
+
   FFT::End();
 }
@@ -53,6 +53,54 @@ TEST_CASE("IO", "[io]")
     std::filesystem::remove(fname);
   }
 
+  SECTION("Streaming")
+  {
+    std::filesystem::path const fname("test-stream.h5");
+    { // Use destructor to ensure it is written
+      HD5::Writer writer(fname);
+      CHECK_NOTHROW(writer.createTensor<Cx, 5>(HD5::Keys::Noncartesian, refData.dimensions()));
+      for (Index iv = volumes - 1; iv >= 0; iv--) {
+        Cx4 const vol = refData.chip<4>(iv) * Cx(iv + 1.f);
+        CHECK_NOTHROW(writer.writeSlab(vol, iv, HD5::Keys::Noncartesian));
+      }
+      CHECK_THROWS_AS(writer.writeSlab(Cx4(refData.chip<4>(0)), volumes, HD5::Keys::Noncartesian), Log::Failure);
+    }
+    HD5::Reader reader(fname);
+    CHECK(reader.dimensions<5>(HD5::Keys::Noncartesian) == refData.dimensions());
+    for (Index iv = 0; iv < volumes; iv++) {
+      auto const check = reader.readSlab<Cx4>(HD5::Keys::Noncartesian, iv);
+      CHECK(Norm(check - refData.chip<4>(iv) * Cx(iv + 1.f)) == Approx(0.f).margin(1.e-9));
+    }
+    std::filesystem::remove(fname);
+  }
+
+  SECTION("Slice")
+  {
+    std::filesystem::path const fname("test-slice.h5");
+    Cx5 data(refData.dimensions());
+    data.setRandom();
+    { // Use destructor to ensure it is written
+      HD5::Writer writer(fname);
+      writer.writeTensor(data, HD5::Keys::Noncartesian);
+    }
+    HD5::Reader reader(fname);
+    Sz5 const start{0, 4, 1, 0, 1}, count{channels, 8, 16, slices, 1}, stride{1, 1, 3, 1, 1};
+    auto const check = reader.readSlice<Cx5>(HD5::Keys::Noncartesian, start, count, stride);
+    Sz5 stop;
+    for (Index ii = 0; ii < 5; ii++) {
+      stop[ii] = start[ii] + (count[ii] - 1) * stride[ii] + 1;
+    }
+    Cx5 const ref = data.stridedSlice(start, stop, stride);
+    CHECK(check.dimensions() == count);
+    CHECK(Norm(check - ref) == Approx(0.f).margin(1.e-9));
+    auto const lores = reader.readSlice<Cx5>(HD5::Keys::Noncartesian, Sz5{0, 0, 0, 0, 0}, Sz5{channels, 4, traces, slices, 1});
+    CHECK(Norm(lores - data.slice(Sz5{0, 0, 0, 0, 0}, Sz5{channels, 4, traces, slices, 1})) == Approx(0.f).margin(1.e-9));
+    CHECK_THROWS_AS(
+      reader.readSlice<Cx5>(HD5::Keys::Noncartesian, Sz5{0, 0, 0, 0, 0}, Sz5{channels, samples + 1, traces, slices, 1}),
+      Log::Failure);
+    std::filesystem::remove(fname);
+  }
+
   SECTION("Real-Data")
   {
     std::filesystem::path const fname("test-real.h5");
@@ -3,6 +3,7 @@
 #include "kernel/nn.hpp"
 #include "kernel/radial.hpp"
 #include "kernel/rectilinear.hpp"
+#include "kernel/tabulated.hpp"
 #include "kernel/triangle.hpp"
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_template_test_macros.hpp>
@@ -18,7 +19,9 @@ TEMPLATE_TEST_CASE(
   (rl::Radial<1, rl::KaiserBessel<3>>),
   (rl::Radial<1, rl::KaiserBessel<5>>),
   (rl::Rectilinear<1, rl::ExpSemi<3>>),
-  (rl::Rectilinear<1, rl::ExpSemi<5>>))
+  (rl::Rectilinear<1, rl::ExpSemi<5>>),
+  (rl::Radial<1, rl::Tabulated<rl::KaiserBessel<3>>>),
+  (rl::Rectilinear<1, rl::Tabulated<rl::ExpSemi<5>, 3>>))
 {
   TestType kernel(2.f);
   typename TestType::Point p;
@@ -33,3 +36,23 @@ TEMPLATE_TEST_CASE(
   CHECK(k1(0) == Approx(0.f).margin(1.e-9));
   CHECK(k1(1) == Approx(k1(TestType::PadWidth - 1)).margin(1.e-5));
 }
+
+TEMPLATE_TEST_CASE(
+  "Tabulated Kernels",
+  "[kernels]",
+  (rl::Tabulated<rl::ExpSemi<5>, 1>),
+  (rl::Tabulated<rl::ExpSemi<5>, 3>),
+  (rl::Tabulated<rl::KaiserBessel<5>, 1>),
+  (rl::Tabulated<rl::KaiserBessel<5>, 3>))
+{
+  rl::Radial<3, TestType> tab(2.f);
+  rl::Radial<3, typename TestType::Func> exact(2.f);
+  rl::Rectilinear<3, TestType> tabRect(2.f);
+  rl::Rectilinear<3, typename TestType::Func> exactRect(2.f);
+  typename rl::Radial<3, TestType>::Point p;
+  for (auto const x : {0.f, 2.e-4f, 0.1f, 0.25f, 0.5f}) { // 2e-4 is in the first table interval
+    p.setConstant(x);
+    CHECK(rl::Norm(Eigen::Tensor<float, 3>(tab(p) - exact(p))) == Approx(0.f).margin(1.e-5));
+    CHECK(rl::Norm(Eigen::Tensor<float, 3>(tabRect(p) - exactRect(p))) == Approx(0.f).margin(1.e-5));
+  }
+}
@@ -1,3 +1,4 @@
+#include "../../src/mapping.hpp"
 #include "../../src/op/make_grid.hpp"
 #include "log.hpp"
 #include "tensorOps.hpp"
@@ -35,3 +36,162 @@ TEST_CASE("Grid Basic", "[grid]")
   ks = grid->forward(img);
   CHECK(Norm(ks) == Approx(Norm(img)).margin(1e-2f));
 }
+
+TEST_CASE("Grid Threads", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 64;
+  Info const info{.matrix = Sz3{M, M, 1}};
+  Re3 points(2, 16, 256);
+  points.setRandom();
+  points = points * points.constant(0.49f);
+  Trajectory const traj(info, points);
+  auto grid = make_grid<Cx, 2>(traj, "ES5", 2.f, 4);
+  Cx3 ks(grid->outputDimensions());
+  ks.setRandom();
+  Threads::SetGlobalThreadCount(1);
+  Cx4 const single = grid->adjoint(ks);
+  Threads::SetGlobalThreadCount(4);
+  Cx4 const multi = grid->adjoint(ks);
+  CHECK(Norm(single) > 0.f);
+  CHECK(Norm(Cx4(multi - single)) == 0.f);
+}
+
+TEST_CASE("Grid Kernel Cache", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 32;
+  Info const info{.matrix = Sz3{M, M, 1}};
+  Re3 points(2, 16, 64);
+  points.setRandom();
+  points = points * points.constant(0.49f);
+  Trajectory const traj(info, points);
+  auto grid = make_grid<Cx, 2>(traj, "ES3", 2.f, 2);
+  auto cached = make_grid<Cx, 2>(traj, "ES3", 2.f, 2, std::nullopt, GridOpts{.kernelCache = 64});
+  Cx3 ks(grid->outputDimensions());
+  ks.setRandom();
+  Cx4 const img = grid->adjoint(ks);
+  CHECK(Norm(Cx4(cached->adjoint(ks) - img)) == Approx(0.f).margin(1.e-6f));
+  CHECK(Norm(Cx3(cached->forward(img) - grid->forward(img))) == Approx(0.f).margin(1.e-6f));
+}
+
+TEST_CASE("Grid Sorted Data", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 32;
+  Info const info{.matrix = Sz3{M, M, 1}};
+  Re3 points(2, 16, 64);
+  points.setRandom();
+  points = points * points.constant(0.49f);
+  points(0, 3, 5) = std::numeric_limits<float>::quiet_NaN(); // Blanked samples must stay zero
+  Trajectory const traj(info, points);
+  auto grid = make_grid<Cx, 2>(traj, "ES3", 2.f, 8);
+  auto sorted = make_grid<Cx, 2>(traj, "ES3", 2.f, 8, std::nullopt, GridOpts{.sorted = true});
+  Cx3 ks(grid->outputDimensions());
+  ks.setRandom();
+  Cx4 const img = grid->adjoint(ks);
+  Cx3 const ks2 = grid->forward(img);
+  CHECK(Norm(Cx4(sorted->adjoint(ks) - img)) == Approx(0.f).margin(1.e-6f));
+  CHECK(Norm(Cx3(sorted->forward(img) - ks2)) == Approx(0.f).margin(1.e-6f));
+}
+
+TEST_CASE("Grid Split Buckets", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 64, samples = 32, traces = 256;
+  Info const info{.matrix = Sz3{M, M, 1}};
+  Re3 points(2, samples, traces); // Radial, so the centre is far denser than the edge
+  for (Index it = 0; it < traces; it++) {
+    float const phi = it * M_PI / traces;
+    for (Index is = 0; is < samples; is++) {
+      points(0, is, it) = (0.5f * is / samples) * std::cos(phi);
+      points(1, is, it) = (0.5f * is / samples) * std::sin(phi);
+    }
+  }
+  Trajectory const traj(info, points);
+  Index const kW = 7, splitSize = 256;
+  Mapping<2> const mapping(traj, 2.f, kW, 32, splitSize);
+
+  std::vector<Index> seen(samples * traces, 0);
+  for (size_t ib = 0; ib < mapping.buckets.size(); ib++) {
+    auto const &bucket = mapping.buckets[ib];
+    CHECK(bucket.size() <= splitSize);
+    if (ib > 0) {
+      CHECK(bucket.size() <= mapping.buckets[ib - 1].size());
+    }
+    CHECK(bucket.start == (ib > 0 ? mapping.buckets[ib - 1].end : 0));
+    for (Index si = bucket.start; si < bucket.end; si++) {
+      seen[si]++;
+      for (Index ii = 0; ii < 2; ii++) {
+        CHECK(mapping.cart[si][ii] - kW / 2 >= bucket.minCorner[ii]);
+        CHECK(mapping.cart[si][ii] + kW / 2 < bucket.maxCorner[ii]);
+      }
+    }
+  }
+  CHECK(std::all_of(seen.begin(), seen.end(), [](Index const n) { return n == 1; }));
+}
+
+TEST_CASE("Grid Subspace", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 32, nB = 4, nT = 2;
+  Info const info{.matrix = Sz3{M, M, 1}};
+  Re3 points(2, 64, 512);
+  points.setRandom();
+  points = points * points.constant(0.49f);
+  Trajectory const traj(info, points);
+  Re2 basis(nB, nT);
+  basis.setRandom();
+  auto grid = make_grid<Cx, 2>(traj, "ES3", 2.f, 3, basis);
+  auto subspace = make_grid<Cx, 2>(traj, "ES3", 2.f, 3, basis, GridOpts{.subspace = true});
+  Cx3 ks(grid->outputDimensions());
+  ks.setRandom();
+  Cx4 const img = grid->adjoint(ks);
+  Cx3 const ks2 = grid->forward(img);
+  CHECK(Norm(Cx4(subspace->adjoint(ks) - img)) == Approx(0.f).margin(1.e-5f * Norm(img)));
+  CHECK(Norm(Cx3(subspace->forward(img) - ks2)) == Approx(0.f).margin(1.e-5f * Norm(ks2)));
+}
+
+TEST_CASE("Grid Shared Mapping", "[grid]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 32, samples = 64, traces = 128;
+  Info const info{.matrix = Sz3{M, M, 1}};
+  Re3 points(2, samples, traces); // Diameters, so downsampling removes samples from both ends
+  for (Index it = 0; it < traces; it++) {
+    float const phi = it * M_PI / traces;
+    for (Index is = 0; is < samples; is++) {
+      points(0, is, it) = (is / float(samples) - 0.5f) * std::cos(phi);
+      points(1, is, it) = (is / float(samples) - 0.5f) * std::sin(phi);
+    }
+  }
+  Trajectory const traj(info, points);
+  Index const kW = 4;
+  auto const mapping = SharedMapping<2>(traj, 2.f, kW);
+  CHECK(SharedMapping<2>(traj, 2.f, kW) == mapping);
+  CHECK(SharedMapping<2>(traj, 2.3f, kW) != mapping);
+
+  auto const [dsTraj, lo, sz] = traj.downsample(2.f, 0, false);
+  REQUIRE(lo > 0);
+  auto const derived = SharedMapping<2>(dsTraj, 2.f, kW);
+  Mapping<2> const built(dsTraj, 2.f, kW);
+  CHECK(derived->noncartDims == built.noncartDims);
+  REQUIRE(derived->cart.size() == built.cart.size());
+  auto samplesOf = [](Mapping<2> const &m) {
+    std::vector<std::tuple<int32_t, int16_t, int16_t, int16_t>> s;
+    for (size_t si = 0; si < m.cart.size(); si++) {
+      s.emplace_back(m.noncart[si].trace, m.noncart[si].sample, m.cart[si][0], m.cart[si][1]);
+    }
+    std::sort(s.begin(), s.end());
+    return s;
+  };
+  CHECK(samplesOf(*derived) == samplesOf(built));
+  for (auto const &bucket : derived->buckets) {
+    for (Index si = bucket.start; si < bucket.end; si++) {
+      for (Index ii = 0; ii < 2; ii++) {
+        CHECK(derived->cart[si][ii] - kW / 2 >= bucket.minCorner[ii]);
+        CHECK(derived->cart[si][ii] + kW / 2 < bucket.maxCorner[ii]);
+      }
+    }
+  }
+}
@@ -26,7 +26,7 @@ TEST_CASE("NUFFT", "[nufft]")
 
   float const osamp = GENERATE(2.f, 2.3f);
   using Kernel = Rectilinear<1, ExpSemi<3>>;
-  Mapping<1> mapping(traj, osamp, Kernel::PadWidth);
+  auto const mapping = std::make_shared<Mapping<1> const>(traj, osamp, Kernel::PadWidth);
 
   std::shared_ptr<GridBase<Cx, 1>> grid = std::make_shared<Grid<Cx, Kernel>>(mapping, 1);
   Index const N = 5;
@@ -40,3 +40,81 @@ TEST_CASE("NUFFT", "[nufft]")
   img = nufft.adjoint(ks);
   CHECK(Norm(img) == Approx(Norm(ks)).margin(2.e-2f));
 }
+
+TEST_CASE("NUFFT Channel Blocks", "[nufft]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 16;
+  Index const nC = 5;
+  Info const info{.matrix = Sz3{M, M, M}};
+  Re3 points(3, 8, 16);
+  points.setRandom();
+  points = points * points.constant(0.49f);
+  Trajectory const traj(info, points);
+
+  auto const identity = std::make_shared<IdentityFunctor<Cx3>>();
+  auto nufft = make_nufft(traj, "ES3", 2.f, nC, traj.matrix());
+  // About 300 KB per channel, so blocks of 3 and 2 channels
+  auto blocked = make_nufft(traj, "ES3", 2.f, nC, traj.matrix(), std::nullopt, identity, GridOpts{.nufftMemory = 1});
+  CHECK(blocked->name() == "ChannelLoopOp");
+
+  Cx5 img(nufft->inputDimensions());
+  img.setRandom();
+  Cx4 ks(nufft->outputDimensions());
+  ks.setRandom();
+  CHECK(Norm(Cx4(blocked->forward(img) - nufft->forward(img))) == Approx(0.f).margin(1.e-6f));
+  CHECK(Norm(Cx5(blocked->adjoint(ks) - nufft->adjoint(ks))) == Approx(0.f).margin(1.e-6f));
+}
+
+TEST_CASE("NUFFT Adjoint", "[nufft]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  // Grids larger than 8 are a multiple of 8 and use the ±1 FFT phase, a grid of 6 uses the complex one
+  Index const M = GENERATE(3, 16);
+  Info const info{.matrix = Sz3{M, M, M}};
+  Re3 points(3, 8, 16);
+  points.setRandom();
+  points = points * points.constant(0.49f);
+  Trajectory const traj(info, points);
+
+  auto nufft = make_nufft(traj, "ES3", 2.f, 2, traj.matrix());
+  Cx5 x(nufft->inputDimensions()), yx(nufft->inputDimensions());
+  Cx4 y(nufft->outputDimensions()), xy(nufft->outputDimensions());
+  x.setRandom();
+  y.setRandom();
+  xy = nufft->forward(x);
+  yx = nufft->adjoint(y);
+  auto const xx = Dot(x, yx);
+  auto const yy = Dot(xy, y);
+  CHECK(std::abs((yy - xx) / (yy + xx + 1.e-15f)) == Approx(0).margin(1.e-4));
+}
+
+TEST_CASE("NUFFT Multi-slice", "[nufft]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 16;
+  Index const nZ = 5;
+  Index const nC = 2;
+  Info const info{.matrix = Sz3{M, M, nZ}};
+  Re3 points(2, 8, 16);
+  points.setRandom();
+  points = points * points.constant(0.49f);
+  Trajectory const traj(info, points);
+
+  auto const identity = std::make_shared<IdentityFunctor<Cx3>>();
+  auto serial = make_nufft(traj, "ES3", 2.f, nC, traj.matrix());
+  auto parallel = make_nufft(traj, "ES3", 2.f, nC, traj.matrix(), std::nullopt, identity, GridOpts{.sliceWorkers = 3});
+  auto batched = make_nufft(traj, "ES3", 2.f, nC, traj.matrix(), std::nullopt, identity, GridOpts{.sliceBatch = true});
+  CHECK(batched->name() == "BatchLoopOp");
+
+  Cx5 img(serial->inputDimensions());
+  img.setRandom();
+  Cx4 ks(serial->outputDimensions());
+  ks.setRandom();
+  Cx4 const y = serial->forward(img);
+  Cx5 const x = serial->adjoint(ks);
+  CHECK(Norm(Cx4(parallel->forward(img) - y)) == Approx(0.f).margin(1.e-6f * Norm(y)));
+  CHECK(Norm(Cx5(parallel->adjoint(ks) - x)) == Approx(0.f).margin(1.e-6f * Norm(x)));
+  CHECK(Norm(Cx4(batched->forward(img) - y)) == Approx(0.f).margin(1.e-5f * Norm(y)));
+  CHECK(Norm(Cx5(batched->adjoint(ks) - x)) == Approx(0.f).margin(1.e-5f * Norm(x)));
+}
@@ -1,4 +1,5 @@
 #include "../src/op/recon.hpp"
+#include "../src/op/toeplitz.hpp"
 #include "log.hpp"
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
@@ -40,3 +41,61 @@ TEST_CASE("Recon", "[recon]")
   ks = recon.forward(img);
   CHECK(Norm(ks) == Approx(Norm(img)).margin(2.e-1f));
 }
+
+TEST_CASE("Recon Toeplitz", "[recon]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 16;
+  Index const nC = 4;
+  Info const info{.matrix = Sz3{M, M, M}};
+  Re3 points(3, 32, 64);
+  points.setRandom();
+  points = points * points.constant(0.49f);
+  Trajectory const traj(info, points);
+
+  float const osamp = 2.f;
+  std::string const ktype = "ES5";
+  auto nufft = make_nufft(traj, ktype, osamp, nC, traj.matrix());
+  Cx4 senseMaps(AddFront(traj.matrix(), nC));
+  senseMaps.setRandom();
+  auto sense = std::make_shared<SenseOp>(senseMaps, 1);
+  MultiplyOp<SenseOp, Operator<Cx, 5, 4>> recon("ReconOp", sense, nufft);
+
+  Cx4 img(recon.inputDimensions());
+  img.setRandom();
+  recon.input() = img;
+  Cx4 const gridded = recon.adjfwd(recon.input());
+  recon.setNormal(std::make_shared<ToeplitzOp>(
+    traj, ktype, osamp, std::make_shared<Cx4 const>(senseMaps), std::nullopt, std::make_shared<IdentityFunctor<Cx3>>(), 3));
+  recon.input() = img;
+  Cx4 const toeplitz = recon.adjfwd(recon.input());
+  CHECK(Norm(Cx4(toeplitz - gridded)) / Norm(gridded) == Approx(0.f).margin(1.e-2f));
+}
+
+TEST_CASE("Recon Shared Buffers", "[recon]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  Index const M = 8;
+  Index const nC = 3;
+  Info const info{.matrix = Sz3{M, M, M}};
+  Re3 points(3, 16, 32);
+  points.setRandom();
+  points = points * points.constant(0.49f);
+  Trajectory const traj(info, points);
+  Cx4 senseMaps(AddFront(traj.matrix(), nC));
+  senseMaps.setRandom();
+
+  // Reference from operators that do not share buffers
+  auto nufft = make_nufft(traj, "ES3", 2.f, nC, traj.matrix());
+  SenseOp sense(senseMaps, 1);
+  Cx4 ks(nufft->outputDimensions());
+  ks.setRandom();
+  Cx4 const ref = sense.adjoint(nufft->adjoint(ks));
+
+  ReconOp recon(
+    "ReconOp", std::make_shared<SenseOp>(senseMaps, 1), make_nufft(traj, "ES3", 2.f, nC, traj.matrix()), true);
+  Cx4 const img = recon.adjoint(ks);
+  CHECK(Norm(Cx4(img - ref)) == Approx(0.f).margin(1.e-6f * Norm(ref)));
+  Cx4 const fwd = recon.forward(img);
+  CHECK(Norm(Cx4(fwd - nufft->forward(sense.forward(img)))) == Approx(0.f).margin(1.e-6f * Norm(fwd)));
+}
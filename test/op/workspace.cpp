@@ -0,0 +1,33 @@
+#include "op/workspace.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+using namespace rl;
+
+TEST_CASE("Workspace", "[workspace]")
+{
+  Cx const *first;
+  {
+    Workspace::Lease<Cx3> a(Sz3{4, 5, 6});
+    first = a->data();
+    a->setConstant(1.f);
+  }
+  SECTION("Reuse")
+  {
+    // Same total size, different shape
+    Workspace::Lease<Cx3> b(Sz3{6, 5, 4});
+    CHECK(b->data() == first);
+    CHECK(b->dimension(0) == 6);
+  }
+  SECTION("Held")
+  {
+    Workspace::Lease<Cx3> b(Sz3{4, 5, 6});
+    Workspace::Lease<Cx3> c(Sz3{4, 5, 6});
+    CHECK(b->data() != c->data());
+  }
+  SECTION("Thread Scratch")
+  {
+    auto s = Workspace::ThreadScratch<Cx3>(Sz3{4, 4, 4});
+    auto t = Workspace::ThreadScratch<Cx3>(Sz3{2, 2, 2});
+    CHECK(s.data() == t.data());
+  }
+}
@@ -0,0 +1,76 @@
+#include "../src/mapping.hpp"
+#include "log.hpp"
+#include "plan-cache.hpp"
+#include "tensorOps.hpp"
+#include "traj_spirals.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace rl;
+
+TEST_CASE("Plan Cache", "[plan-cache]")
+{
+  Log::SetLevel(Log::Level::Testing);
+  std::filesystem::path const dir("test-plan-cache");
+  PlanCache::SetDirectory(dir.string());
+  REQUIRE(PlanCache::Enabled());
+
+  Index const M = 32;
+  Info const info{.matrix = Sz3{M, M, M}};
+  Trajectory const traj(info, ArchimedeanSpiral(M, 256));
+
+  SECTION("Mapping")
+  {
+    Mapping<3> const built(traj, 2.f, 4, 8, 64);
+    REQUIRE(std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()) == 1);
+    Mapping<3> const loaded(traj, 2.f, 4, 8, 64);
+    CHECK(loaded.cartDims == built.cartDims);
+    CHECK(loaded.cart == built.cart);
+    CHECK(std::equal(built.offset.begin(), built.offset.end(), loaded.offset.begin(), loaded.offset.end(), [](auto const &a, auto const &b) {
+      return (a == b).all();
+    }));
+    CHECK(loaded.sortedIndices == built.sortedIndices);
+    CHECK(loaded.colors == built.colors);
+    REQUIRE(loaded.buckets.size() == built.buckets.size());
+    for (size_t ib = 0; ib < built.buckets.size(); ib++) {
+      CHECK(loaded.buckets[ib].minCorner == built.buckets[ib].minCorner);
+      CHECK(loaded.buckets[ib].maxCorner == built.buckets[ib].maxCorner);
+      CHECK(loaded.buckets[ib].start == built.buckets[ib].start);
+      CHECK(loaded.buckets[ib].end == built.buckets[ib].end);
+    }
+    Mapping<3> const other(traj, 2.f, 4, 8, 128); // Different parameters must not hit the same entry
+    CHECK(std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator()) == 2);
+  }
+
+  SECTION("Corrupt")
+  {
+    PlanCache::Key key;
+    key.add(std::string("test"));
+    Re2 t(4, 5);
+    t.setRandom();
+    PlanCache::StoreTensor("tensor", key, t);
+    auto const check = PlanCache::LoadTensor<float, 2>("tensor", key);
+    REQUIRE(check);
+    CHECK(Norm(check.value() - t) == 0.f);
+    CHECK_FALSE(PlanCache::LoadTensor<float, 2>("tensor", PlanCache::Key().add(std::string("other"))));
+    auto const entry = std::filesystem::directory_iterator(dir)->path();
+    std::filesystem::resize_file(entry, std::filesystem::file_size(entry) - 4);
+    CHECK_FALSE(PlanCache::LoadTensor<float, 2>("tensor", key));
+    // A corrupt length must be a miss, not an enormous allocation
+    PlanCache::StoreTensor("tensor", key, t);
+    REQUIRE(PlanCache::LoadTensor<float, 2>("tensor", key));
+    {
+      std::fstream f(entry, std::ios::in | std::ios::out | std::ios::binary);
+      f.seekp(std::filesystem::file_size(entry) - t.size() * sizeof(float) - sizeof(Eigen::DSizes<Index, 2>));
+      Index const huge = Index(1) << 60;
+      f.write(reinterpret_cast<char const *>(&huge), sizeof(huge));
+    }
+    CHECK_FALSE(PlanCache::LoadTensor<float, 2>("tensor", key));
+  }
+
+  std::filesystem::remove_all(dir);
+  PlanCache::SetDirectory("");
+}